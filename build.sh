@@ -5,12 +5,15 @@ do
     # echo $arch
     CC=${arch}-linux-gnu-gcc
     ARCH_CFLAGS=""
+    GPR_CFLAGS=""
     case $arch in
         x86_64|aarch64)
-        ARCH_CFLAGS="-mgeneral-regs-only -T vmlinux.lds"
+        GPR_CFLAGS="-mgeneral-regs-only"
+        ARCH_CFLAGS="-T vmlinux.lds"
             ;;
         i686)
-        ARCH_CFLAGS="-mgeneral-regs-only -T vmlinux.lds -UTIMER_RES_DIVIDER -DTIMER_RES_DIVIDER=1000"
+        GPR_CFLAGS="-mgeneral-regs-only"
+        ARCH_CFLAGS="-T vmlinux.lds -UTIMER_RES_DIVIDER -DTIMER_RES_DIVIDER=1000"
             ;;
     # loongarch64)
     #    ARCH_CFLAGS="-Ttext 0x400000"
@@ -22,16 +25,28 @@ do
 
     if which ${CC} > /dev/null; then
         echo $arch
+        MATRIX_SRC=core_matrix.c
+        case " $* " in
+            *" -DMATRIX_SIMD=1 "*)
+            # the vector matrix kernels need the SIMD registers that the
+            # rest of the image does without
+            MATRIX_SRC=core_matrix_${arch}.o
+            ${CC} -O2 -Ilinux -Iposix -I. -DITERATIONS=0 -DPERFORMANCE_RUN=1 \
+                -DTIMER_RES_DIVIDER=1 -DHAS_FLOAT=0 -DHAS_PRINTF=0 -DMEM_METHOD=MEM_STATIC \
+                -fno-pie -c core_matrix.c -o ${MATRIX_SRC} "$@" || continue
+                ;;
+        esac
         ${CC} -O2 -Ilinux -Iposix -I. -DFLAGS_STR=\""-O2 -DPERFORMANCE_RUN=1 -lrt"\" \
             -DITERATIONS=0 -DPERFORMANCE_RUN=1 \
-            core_list_join.c core_main.c core_matrix.c core_state.c core_util.c posix/core_portme.c \
+            core_list_join.c core_main.c ${MATRIX_SRC} core_state.c core_util.c posix/core_portme.c \
             -o ./coremark_nolibc_nofp_${arch}.exe \
             -static -DTIMER_RES_DIVIDER=1 -DHAS_FLOAT=0 -DHAS_PRINTF=0 -DMEM_METHOD=MEM_STATIC \
             minic.c \
             -nostdlib -fno-pie \
             -Wl,--build-id=none -Wl,-z,max-page-size=65536 \
-            $ARCH_CFLAGS \
+            $GPR_CFLAGS $ARCH_CFLAGS \
             "$@"
+        [ "${MATRIX_SRC}" = core_matrix.c ] || rm -f ${MATRIX_SRC}
     else
         echo ${CC} dose not exist, skip
     fi
@@ -39,4 +54,6 @@ do
 done
 
 # -DNO_STACK=1 -DMAIN_HAS_NOARGC=1 -DSEED_METHOD=SEED_VOLATILE -DITERATIONS=10
-
+# -DMULTITHREAD=8 -DUSE_CLONE=1 (run with M<n> as first argument)
+# -UMEM_METHOD -DMEM_METHOD=MEM_MALLOC -DUSE_HUGEPAGES=1
+# profile optimized images: make PORT_DIR=nolibc ARCH=<arch> PGO=1 LTO=1
@@ -50,6 +50,27 @@ input for the operation.
 
 /* local functions */
 
+#if LIST_SOA
+list_link core_list_find(list_head *l, list_link list, list_data *info);
+list_link core_list_reverse(list_head *l, list_link list);
+list_link core_list_remove(list_head *l, list_link item);
+list_link core_list_undo_remove(list_head *l,
+                                list_link  item_removed,
+                                list_link  item_modified);
+list_link core_list_insert_new(list_head *l,
+                               list_link  insert_point,
+                               list_data *info,
+                               list_link *next_free,
+                               list_link  end);
+typedef ee_s32 (*list_cmp)(list_head    *l,
+                           list_link     a,
+                           list_link     b,
+                           core_results *res);
+list_link core_list_mergesort(list_head    *l,
+                              list_link     list,
+                              list_cmp      cmp,
+                              core_results *res);
+#else
 list_head *core_list_find(list_head *list, list_data *info);
 list_head *core_list_reverse(list_head *list);
 list_head *core_list_remove(list_head *item);
@@ -65,17 +86,58 @@ typedef ee_s32 (*list_cmp)(list_data *a, list_data *b, core_results *res);
 list_head *core_list_mergesort(list_head *   list,
                                list_cmp      cmp,
                                core_results *res);
+#if (LIST_SORT == LIST_SORT_RUNS)
+list_head *core_list_sort_complex(list_head *list, core_results *res);
+list_head *core_list_sort_idx(list_head *list);
+#endif
+#endif
+
+#if (CALC_CACHE == CALC_CACHE_TABLE)
+#if (CALC_CACHE_SIZE & (CALC_CACHE_SIZE - 1))
+#error "CALC_CACHE_SIZE must be a power of 2"
+#endif
+/* Function: calc_cache_clear
+        Empty the <calc_func> table of a context.
+*/
+static void
+calc_cache_clear(core_results *res)
+{
+    ee_u32 i;
+    for (i = 0; i < CALC_CACHE_SIZE; i++)
+        res->ccache[i].value = -1;
+}
+#endif
 
 ee_s16
 calc_func(ee_s16 *pdata, core_results *res)
 {
     ee_s16 data = *pdata;
     ee_s16 retval;
+#if KERNEL_TIMING
+    ee_u8 kernel;
+#endif
     ee_u8  optype
         = (data >> 7)
           & 1;  /* bit 7 indicates if the function result has been cached */
+#if (CALC_CACHE == CALC_CACHE_TABLE)
+    /* the list items set bit 7 only for the head and tail items */
+    calc_entry *entry
+        = &res->ccache[(data ^ (data >> 4)) & (CALC_CACHE_SIZE - 1)];
+    if (!optype && entry->key == data && entry->value >= 0)
+    {
+#if CALC_STATS
+        res->cstats.hits++;
+#endif
+        return entry->value;
+    }
+#endif
     if (optype) /* if cached, use cache */
+    {
+#if CALC_STATS
+        res->cstats.hits++;
+#endif
         return (data & 0x007f);
+    }
     else
     {                             /* otherwise calculate and cache the result */
         ee_s16 flag = data & 0x7; /* bits 0-2 is type of function to perform */
@@ -88,30 +150,508 @@ calc_func(ee_s16 *pdata, core_results *res)
             case 0:
                 if (dtype < 0x22) /* set min period for bit corruption */
                     dtype = 0x22;
+#if KERNEL_TIMING
+                kernel = kernel_switch(&res->ktimes, KERNEL_STATE);
+#endif
                 retval = core_bench_state(res->size,
                                           res->memblock[3],
                                           res->seed1,
                                           res->seed2,
                                           dtype,
                                           res->crc);
+#if KERNEL_TIMING
+                kernel_switch(&res->ktimes, kernel);
+#endif
                 if (res->crcstate == 0)
                     res->crcstate = retval;
+#if CALC_STATS
+                res->cstats.dispatch[CALC_STATE]++;
+#endif
                 break;
             case 1:
+#if KERNEL_TIMING
+                kernel = kernel_switch(&res->ktimes, KERNEL_MATRIX);
+#endif
                 retval = core_bench_matrix(&(res->mat), dtype, res->crc);
+#if KERNEL_TIMING
+                kernel_switch(&res->ktimes, kernel);
+#endif
                 if (res->crcmatrix == 0)
                     res->crcmatrix = retval;
+#if CALC_STATS
+                res->cstats.dispatch[CALC_MATRIX]++;
+#endif
                 break;
             default:
                 retval = data;
+#if CALC_STATS
+                res->cstats.dispatch[CALC_NONE]++;
+#endif
                 break;
         }
+#if CALC_STATS
+        res->cstats.misses++;
+#endif
         res->crc = crcu16(retval, res->crc);
         retval &= 0x007f;
+#if (CALC_CACHE == CALC_CACHE_TABLE)
+        entry->key   = data;
+        entry->value = retval;
+#else
         *pdata = (data & 0xff00) | 0x0080 | retval; /* cache the result */
+#endif
         return retval;
     }
 }
+#if LIST_SOA
+#if LIST_CHASE
+#error "LIST_CHASE lays out pointer cells, it cannot be used with LIST_SOA"
+#endif
+#if (LIST_SORT != LIST_SORT_MERGE)
+#error "LIST_SORT engines other than LIST_SORT_MERGE need the cell layout"
+#endif
+/* Topic: Array layout
+        With LIST_SOA the list is a <list_head> of arrays: a cell is an index
+   in next and info, and info gives the index of its data item in data16 and
+   idx. Each function below does the same steps as the cell version in the
+   #else part, only over indices, so the list goes through the same states.
+*/
+
+/* Function: cmp_complex
+        Compare the data items a and b.
+
+        Can be used by mergesort.
+*/
+ee_s32
+cmp_complex(list_head *l, list_link a, list_link b, core_results *res)
+{
+    ee_s16 val1 = calc_func(&(l->data16[a]), res);
+    ee_s16 val2 = calc_func(&(l->data16[b]), res);
+    return val1 - val2;
+}
+
+/* Function: cmp_idx
+        Compare the idx of the data items a and b, and regen the data.
+
+        Can be used by mergesort.
+*/
+ee_s32
+cmp_idx(list_head *l, list_link a, list_link b, core_results *res)
+{
+    if (res == NULL)
+    {
+        l->data16[a]
+            = (l->data16[a] & 0xff00) | (0x00ff & (l->data16[a] >> 8));
+        l->data16[b]
+            = (l->data16[b] & 0xff00) | (0x00ff & (l->data16[b] >> 8));
+    }
+    return l->idx[a] - l->idx[b];
+}
+
+/* Benchmark for linked list, see the cell version.
+ */
+ee_u16
+core_bench_list(core_results *res, ee_s16 finder_idx)
+{
+    ee_u16     retval = 0;
+    ee_u16     found = 0, missed = 0;
+    list_head *l        = res->list;
+    list_link  list     = l->head;
+    ee_s16     find_num = res->seed3;
+    list_link  this_find;
+    list_link  finder, remover;
+    list_data  info = {0};
+    ee_s16     i;
+#if KERNEL_TIMING
+    ee_u8 kernel = kernel_switch(&res->ktimes, KERNEL_LIST_FIND);
+#endif
+#if (CALC_CACHE == CALC_CACHE_TABLE)
+    calc_cache_clear(res);
+#endif
+
+    info.idx = finder_idx;
+    /* find <find_num> values in the list, and change the list each time
+     * (reverse and cache if value found) */
+    for (i = 0; i < find_num; i++)
+    {
+        info.data16 = (i & 0xff);
+        this_find   = core_list_find(l, list, &info);
+        list        = core_list_reverse(l, list);
+        if (this_find == LIST_NIL)
+        {
+            missed++;
+            retval += (l->data16[l->info[l->next[list]]] >> 8) & 1;
+        }
+        else
+        {
+            found++;
+            if (l->data16[l->info[this_find]] & 0x1) /* use found value */
+                retval += (l->data16[l->info[this_find]] >> 9) & 1;
+            /* and cache next item at the head of the list (if any) */
+            if (l->next[this_find] != LIST_NIL)
+            {
+                finder             = l->next[this_find];
+                l->next[this_find] = l->next[finder];
+                l->next[finder]    = l->next[list];
+                l->next[list]      = finder;
+            }
+        }
+        if (info.idx >= 0)
+            info.idx++;
+#if CORE_DEBUG
+        ee_printf("List find %d: [%d,%d,%d]\n", i, retval, missed, found);
+#endif
+    }
+    retval += found * 4 - missed;
+#if KERNEL_TIMING
+    kernel_switch(&res->ktimes, KERNEL_LIST_SORT);
+#endif
+    /* sort the list by data content and remove one item*/
+    if (finder_idx > 0)
+        list = core_list_mergesort(l, list, cmp_complex, res);
+    remover = core_list_remove(l, l->next[list]);
+    /* CRC data content of list from location of index N forward, and then undo
+     * remove */
+    finder = core_list_find(l, list, &info);
+    if (finder == LIST_NIL)
+        finder = l->next[list];
+    while (finder != LIST_NIL)
+    {
+        retval = crc16(l->data16[l->info[list]], retval);
+        finder = l->next[finder];
+    }
+#if CORE_DEBUG
+    ee_printf("List sort 1: %04x\n", retval);
+#endif
+    remover = core_list_undo_remove(l, remover, l->next[list]);
+    /* sort the list by index, in effect returning the list to original state */
+    list = core_list_mergesort(l, list, cmp_idx, NULL);
+    /* CRC data content of list */
+    finder = l->next[list];
+    while (finder != LIST_NIL)
+    {
+        retval = crc16(l->data16[l->info[list]], retval);
+        finder = l->next[finder];
+    }
+#if CORE_DEBUG
+    ee_printf("List sort 2: %04x\n", retval);
+#endif
+#if KERNEL_TIMING
+    kernel_switch(&res->ktimes, kernel);
+#endif
+    return retval;
+}
+
+/* Function: core_list_init
+        Initialize list with data.
+
+        The <list_head> is put at the start of the memory block, followed by
+   the arrays. The number of items is computed as for the cell layout, which
+   needs more memory per item, so that the same list is built.
+
+        Returns:
+        Pointer to the <list_head>.
+*/
+list_head *
+core_list_init(ee_u32 blksize, list_head *memblock, ee_s16 seed)
+{
+    /* calculated pointers for the list */
+    ee_u32 per_item = 16 + sizeof(struct list_data_s);
+    ee_u32 size     = (blksize / per_item)
+                  - 2; /* to accommodate systems with 64b pointers, and make sure
+                          same code is executed, set max list elements */
+    list_head *l = memblock;
+    /* some useful variables */
+    ee_u32    i;
+    list_link finder, list = 0, next_free = 0;
+    list_data info;
+
+    if (size > LIST_NIL - 1)
+        size = LIST_NIL - 1;
+    l->next   = (list_link *)(l + 1);
+    l->info   = l->next + size;
+    l->data16 = (ee_s16 *)(l->info + size);
+    l->idx    = l->data16 + size;
+
+    /* create a fake items for the list head and tail */
+    l->next[list] = LIST_NIL;
+    l->info[list] = 0;
+    l->idx[0]    = 0x0000;
+    l->data16[0] = (ee_s16)0x8080;
+    next_free++;
+    info.idx    = 0x7fff;
+    info.data16 = (ee_s16)0xffff;
+    core_list_insert_new(l, list, &info, &next_free, size);
+
+    /* then insert size items */
+    for (i = 0; i < size; i++)
+    {
+        ee_u16 datpat = ((ee_u16)(seed ^ i) & 0xf);
+        ee_u16 dat
+            = (datpat << 3) | (i & 0x7); /* alternate between algorithms */
+        info.data16 = (dat << 8) | dat;  /* fill the data with actual data and
+                                            upper bits with rebuild value */
+        core_list_insert_new(l, list, &info, &next_free, size);
+    }
+    /* and now index the list so we know initial seed order of the list */
+    finder = l->next[list];
+    i      = 1;
+    while (l->next[finder] != LIST_NIL)
+    {
+        if (i < size / 5) /* first 20% of the list in order */
+            l->idx[l->info[finder]] = i++;
+        else
+        {
+            ee_u16 pat = (ee_u16)(i++ ^ seed); /* get a pseudo random number */
+            l->idx[l->info[finder]]
+                = 0x3fff & (((i & 0x07) << 8) | pat); /* make sure the mixed
+                                                         items end up after
+                                                         the ones in sequence */
+        }
+        finder = l->next[finder];
+    }
+    l->head = core_list_mergesort(l, list, cmp_idx, NULL);
+#if CORE_DEBUG
+    ee_printf("Initialized list:\n");
+    finder = l->head;
+    while (finder != LIST_NIL)
+    {
+        ee_printf("[%04x,%04x]",
+                  l->idx[l->info[finder]],
+                  (ee_u16)l->data16[l->info[finder]]);
+        finder = l->next[finder];
+    }
+    ee_printf("\n");
+#endif
+    return l;
+}
+
+/* Function: core_list_insert
+        Insert an item to the list, taking the next free cell and data item,
+   which have the same index, below end.
+
+        Returns:
+        New item, or LIST_NIL if there is no room left.
+*/
+list_link
+core_list_insert_new(list_head *l,
+                     list_link  insert_point,
+                     list_data *info,
+                     list_link *next_free,
+                     list_link  end)
+{
+    list_link newitem;
+
+    if ((*next_free + 1) >= end)
+        return LIST_NIL;
+
+    newitem = *next_free;
+    (*next_free)++;
+    l->next[newitem]      = l->next[insert_point];
+    l->next[insert_point] = newitem;
+
+    l->info[newitem]   = newitem;
+    l->data16[newitem] = info->data16;
+    l->idx[newitem]    = info->idx;
+
+    return newitem;
+}
+
+/* Function: core_list_remove
+        Remove an item from the list, by swapping the data items of item and
+   the next cell and unlinking the next cell.
+
+        Returns:
+        Removed item.
+*/
+list_link
+core_list_remove(list_head *l, list_link item)
+{
+    list_link tmp;
+    list_link ret = l->next[item];
+    /* swap data items */
+    tmp           = l->info[item];
+    l->info[item] = l->info[ret];
+    l->info[ret]  = tmp;
+    /* and eliminate item */
+    l->next[item] = l->next[ret];
+    l->next[ret]  = LIST_NIL;
+    return ret;
+}
+
+/* Function: core_list_undo_remove
+        Undo a remove operation.
+
+        Returns:
+        The item that was linked back to the list.
+*/
+list_link
+core_list_undo_remove(list_head *l,
+                      list_link  item_removed,
+                      list_link  item_modified)
+{
+    list_link tmp;
+    /* swap data items */
+    tmp                    = l->info[item_removed];
+    l->info[item_removed]  = l->info[item_modified];
+    l->info[item_modified] = tmp;
+    /* and insert item */
+    l->next[item_removed]  = l->next[item_modified];
+    l->next[item_modified] = item_removed;
+    return item_removed;
+}
+
+/* Function: core_list_find
+        Find an item by idx (if not 0) or specific data value.
+
+        Returns:
+        Found item, or LIST_NIL if not found.
+*/
+list_link
+core_list_find(list_head *l, list_link list, list_data *info)
+{
+    if (info->idx >= 0)
+    {
+        while (list != LIST_NIL && (l->idx[l->info[list]] != info->idx))
+            list = l->next[list];
+        return list;
+    }
+    else
+    {
+        while (list != LIST_NIL
+               && ((l->data16[l->info[list]] & 0xff) != info->data16))
+            list = l->next[list];
+        return list;
+    }
+}
+
+/* Function: core_list_reverse
+        Reverse a list.
+
+        Returns:
+        New head of the list.
+*/
+list_link
+core_list_reverse(list_head *l, list_link list)
+{
+    list_link next = LIST_NIL, tmp;
+    while (list != LIST_NIL)
+    {
+        tmp           = l->next[list];
+        l->next[list] = next;
+        next          = list;
+        list          = tmp;
+    }
+    return next;
+}
+
+/* Function: core_list_mergesort
+        Sort the list in place without recursion, see the cell version.
+
+        Returns:
+        New head of the list.
+*/
+list_link
+core_list_mergesort(list_head    *l,
+                    list_link     list,
+                    list_cmp      cmp,
+                    core_results *res)
+{
+    list_link p, q, e, tail;
+    ee_s32    insize, nmerges, psize, qsize, i;
+
+    insize = 1;
+
+    while (1)
+    {
+        p    = list;
+        list = LIST_NIL;
+        tail = LIST_NIL;
+
+        nmerges = 0; /* count number of merges we do in this pass */
+
+        while (p != LIST_NIL)
+        {
+            nmerges++; /* there exists a merge to be done */
+            /* step `insize' places along from p */
+            q     = p;
+            psize = 0;
+            for (i = 0; i < insize; i++)
+            {
+                psize++;
+                q = l->next[q];
+                if (q == LIST_NIL)
+                    break;
+            }
+
+            /* if q hasn't fallen off end, we have two lists to merge */
+            qsize = insize;
+
+            /* now we have two lists; merge them */
+            while (psize > 0 || (qsize > 0 && q != LIST_NIL))
+            {
+
+                /* decide whether next element of merge comes from p or q */
+                if (psize == 0)
+                {
+                    /* p is empty; e must come from q. */
+                    e = q;
+                    q = l->next[q];
+                    qsize--;
+                }
+                else if (qsize == 0 || q == LIST_NIL)
+                {
+                    /* q is empty; e must come from p. */
+                    e = p;
+                    p = l->next[p];
+                    psize--;
+                }
+                else if (cmp(l, l->info[p], l->info[q], res) <= 0)
+                {
+                    /* First element of p is lower (or same); e must come from
+                     * p. */
+                    e = p;
+                    p = l->next[p];
+                    psize--;
+                }
+                else
+                {
+                    /* First element of q is lower; e must come from q. */
+                    e = q;
+                    q = l->next[q];
+                    qsize--;
+                }
+
+                /* add the next element to the merged list */
+                if (tail != LIST_NIL)
+                {
+                    l->next[tail] = e;
+                }
+                else
+                {
+                    list = e;
+                }
+                tail = e;
+            }
+
+            /* now p has stepped `insize' places along, and q has too */
+            p = q;
+        }
+
+        l->next[tail] = LIST_NIL;
+
+        /* If we have done only one merge, we're finished. */
+        if (nmerges <= 1) /* allow for nmerges==0, the empty list case */
+            return list;
+
+        /* Otherwise repeat, merging lists twice the size */
+        insize *= 2;
+    }
+#if COMPILER_REQUIRES_SORT_RETURN
+    return list;
+#endif
+}
+#else
 /* Function: cmp_complex
         Compare the data item in a list cell.
 
@@ -148,6 +688,151 @@ copy_info(list_data *to, list_data *from)
     to->idx    = from->idx;
 }
 
+#if (LIST_SORT == LIST_SORT_RUNS)
+/* Topic: Run sort
+        The sort engine of LIST_SORT_RUNS. Both comparators are called
+   directly, so that the compiler can inline them.
+
+        <cmp_complex> fills the <calc_func> cache, and the kernels run by a
+   miss fold the running crc into their result, so the order of the first
+   comparison of each item is part of the CRC. The sort by data therefore
+   keeps the merges of <core_list_mergesort>, pass by pass and pair by pair.
+   The sort by idx has no order dependent side effect, as the regen of
+   <cmp_idx> only needs every item compared once. It merges the natural
+   runs of the list instead, which any stable merge sort orders the same.
+*/
+
+/* Function: LIST_MERGE
+        Define name(tail, p, q, res), merging the sorted lists p and q after
+   tail with the comparisons of <core_list_mergesort>, and returning the new
+   tail.
+*/
+#define LIST_MERGE(name, cmp)                                              \
+    static list_head *name(                                                \
+        list_head *tail, list_head *p, list_head *q, core_results *res)    \
+    {                                                                      \
+        while (p && q)                                                     \
+        {                                                                  \
+            if (cmp(p->info, q->info, res) <= 0)                           \
+            {                                                              \
+                tail->next = p;                                            \
+                p          = p->next;                                      \
+            }                                                              \
+            else                                                           \
+            {                                                              \
+                tail->next = q;                                            \
+                q          = q->next;                                      \
+            }                                                              \
+            tail = tail->next;                                             \
+        }                                                                  \
+        tail->next = p ? p : q;                                            \
+        while (tail->next)                                                 \
+            tail = tail->next;                                             \
+        return tail;                                                       \
+    }
+
+LIST_MERGE(list_merge_complex, cmp_complex)
+LIST_MERGE(list_merge_idx, cmp_idx)
+
+/* Function: list_cut
+        Cut the list after its first n items.
+
+        Returns:
+        The rest of the list.
+*/
+static list_head *
+list_cut(list_head *list, ee_s32 n)
+{
+    list_head *rest;
+    if (!list)
+        return NULL;
+    while (--n > 0 && list->next)
+        list = list->next;
+    rest       = list->next;
+    list->next = NULL;
+    return rest;
+}
+
+/* Function: core_list_sort_complex
+        Sort the list by <cmp_complex>, merging lists of 1, 2, 4, ... items as
+   <core_list_mergesort> does.
+
+        Returns:
+        New head of the list.
+*/
+list_head *
+core_list_sort_complex(list_head *list, core_results *res)
+{
+    list_head  head;
+    list_head *tail, *p, *q, *next;
+    ee_s32     insize, nmerges;
+
+    for (insize = 1;; insize *= 2)
+    {
+        tail    = &head;
+        p       = list;
+        nmerges = 0;
+        while (p)
+        {
+            nmerges++;
+            q    = list_cut(p, insize);
+            next = list_cut(q, insize);
+            tail = list_merge_complex(tail, p, q, res);
+            p    = next;
+        }
+        tail->next = NULL;
+        list       = head.next;
+        if (nmerges <= 1)
+            return list;
+    }
+}
+
+/* Function: core_list_sort_idx
+        Sort the list by <cmp_idx>, with regen. Each natural run is cut from
+   the head of the list and carried into a binary counter of merged runs,
+   bins[i] holding 2^i runs, earlier runs always on the left of a merge so
+   that the sort is stable.
+
+        Returns:
+        New head of the list.
+*/
+list_head *
+core_list_sort_idx(list_head *list)
+{
+    list_head *bins[32], *run, *end;
+    list_head  head;
+    ee_u32     i;
+
+    for (i = 0; i < 32; i++)
+        bins[i] = NULL;
+    while (list)
+    {
+        end = list;
+        while (end->next && cmp_idx(end->info, end->next->info, NULL) <= 0)
+            end = end->next;
+        run       = list;
+        list      = end->next;
+        end->next = NULL;
+        for (i = 0; bins[i]; i++) /* less than 2^32 runs */
+        {
+            list_merge_idx(&head, bins[i], run, NULL);
+            run     = head.next;
+            bins[i] = NULL;
+        }
+        bins[i] = run;
+    }
+    for (run = NULL, i = 0; i < 32; i++)
+    {
+        if (bins[i])
+        {
+            list_merge_idx(&head, bins[i], run, NULL);
+            run = head.next;
+        }
+    }
+    return run;
+}
+#endif
+
 /* Benchmark for linked list:
         - Try to find multiple data items.
         - List sort
@@ -166,6 +851,12 @@ core_bench_list(core_results *res, ee_s16 finder_idx)
     list_head *finder, *remover;
     list_data  info = {0};
     ee_s16     i;
+#if KERNEL_TIMING
+    ee_u8 kernel = kernel_switch(&res->ktimes, KERNEL_LIST_FIND);
+#endif
+#if (CALC_CACHE == CALC_CACHE_TABLE)
+    calc_cache_clear(res);
+#endif
 
     info.idx = finder_idx;
     /* find <find_num> values in the list, and change the list each time
@@ -201,9 +892,16 @@ core_bench_list(core_results *res, ee_s16 finder_idx)
 #endif
     }
     retval += found * 4 - missed;
+#if KERNEL_TIMING
+    kernel_switch(&res->ktimes, KERNEL_LIST_SORT);
+#endif
     /* sort the list by data content and remove one item*/
     if (finder_idx > 0)
+#if (LIST_SORT == LIST_SORT_RUNS)
+        list = core_list_sort_complex(list, res);
+#else
         list = core_list_mergesort(list, cmp_complex, res);
+#endif
     remover = core_list_remove(list->next);
     /* CRC data content of list from location of index N forward, and then undo
      * remove */
@@ -220,7 +918,11 @@ core_bench_list(core_results *res, ee_s16 finder_idx)
 #endif
     remover = core_list_undo_remove(remover, list->next);
     /* sort the list by index, in effect returning the list to original state */
+#if (LIST_SORT == LIST_SORT_RUNS)
+    list = core_list_sort_idx(list);
+#else
     list = core_list_mergesort(list, cmp_idx, NULL);
+#endif
     /* CRC data content of list */
     finder = list->next;
     while (finder)
@@ -230,6 +932,9 @@ core_bench_list(core_results *res, ee_s16 finder_idx)
     }
 #if CORE_DEBUG
     ee_printf("List sort 2: %04x\n", retval);
+#endif
+#if KERNEL_TIMING
+    kernel_switch(&res->ktimes, kernel);
 #endif
     return retval;
 }
@@ -303,7 +1008,11 @@ core_list_init(ee_u32 blksize, list_head *memblock, ee_s16 seed)
         }
         finder = finder->next;
     }
+#if (LIST_SORT == LIST_SORT_RUNS)
+    list = core_list_sort_idx(list);
+#else
     list = core_list_mergesort(list, cmp_idx, NULL);
+#endif
 #if CORE_DEBUG
     ee_printf("Initialized list:\n");
     finder = list;
@@ -593,3 +1302,114 @@ core_list_mergesort(list_head *list, list_cmp cmp, core_results *res)
     return list;
 #endif
 }
+
+#if LIST_CHASE
+#if (LIST_CHASE_STRIDE < 32) || (LIST_CHASE_STRIDE & (LIST_CHASE_STRIDE - 1))
+#error "LIST_CHASE_STRIDE must be a power of 2 of at least 32 bytes"
+#endif
+/* Function: list_chase_slot
+        Slot of the cell i in a list of 2^bits cells. A few rounds of xor with
+   the seed, multiplication by an odd constant and xorshift, each a bijection
+   on bits bits, so every slot gets one cell and consecutive cells are far
+   apart in no fixed stride.
+*/
+static ee_u32
+list_chase_slot(ee_u32 i, ee_u32 bits, ee_u32 seed)
+{
+    ee_u32 mask = ((ee_u32)1 << bits) - 1;
+    ee_u32 round;
+    for (round = 0; round < 3; round++)
+    {
+        i = (i ^ seed) & mask;
+        i = (i * 0x9e3779b1) & mask;
+        i ^= i >> ((bits + 1) / 2);
+    }
+    return i;
+}
+
+/* Function: core_list_chase_init
+        Link a list over the arena for <core_list_chase>, one cell and its
+   data per slot of stride bytes, visiting the slots in a random order drawn
+   from seed. The number of cells, the largest power of 2 that fits, is
+   returned in cells.
+
+        Returns:
+        Head of the list.
+*/
+list_head *
+core_list_chase_init(ee_u8  *arena,
+                     ee_u32  size,
+                     ee_u32  stride,
+                     ee_s16  seed,
+                     ee_u32 *cells)
+{
+    ee_u32     bits = 0, i;
+    list_head *cell, *prev = NULL, *list = NULL;
+
+    while (((ee_u32)2 << bits) <= size / stride && bits < 31)
+        bits++;
+    *cells = (ee_u32)1 << bits;
+    for (i = 0; i < *cells; i++)
+    {
+        cell = (list_head *)(arena
+                             + (ee_size_t)list_chase_slot(
+                                   i, bits, (ee_u16)seed * 0x10001)
+                                   * stride);
+        cell->next         = NULL;
+        cell->info         = (list_data *)(cell + 1);
+        cell->info->data16 = (ee_s16)0x8080;
+        cell->info->idx    = (ee_s16)i;
+        if (prev)
+            prev->next = cell;
+        else
+            list = cell;
+        prev = cell;
+    }
+    return list;
+}
+
+/* Function: core_list_chase
+        Walk the list passes times, with <core_list_find> looking for a value
+   no cell holds, or with <core_list_reverse>.
+
+        Returns:
+        Number of finds that stopped on a cell, which should be 0. See
+   <core_list_chase_hops> for the cells the walks went through.
+*/
+ee_u32
+core_list_chase(list_head **list, ee_u32 passes, ee_u8 reverse)
+{
+    list_data info;
+    ee_u32    found = 0;
+
+    info.idx    = -1;
+    info.data16 = 1;
+    while (passes--)
+    {
+        if (reverse)
+            *list = core_list_reverse(*list);
+        else
+            found += (core_list_find(*list, &info) != NULL);
+    }
+    return found;
+}
+
+/* Function: core_list_chase_hops
+        Walk the list once more, outside of the timed walks, counting the
+   hops.
+
+        Returns:
+        Number of cells reached from the head, which should be the cells of
+   <core_list_chase_init>.
+*/
+ee_u32
+core_list_chase_hops(list_head *list)
+{
+    ee_u32 hops = 0;
+
+    for (; list; list = list->next)
+        hops++;
+    return hops;
+}
+#endif
+#endif
@@ -59,19 +59,601 @@ iterate(void *pres)
     res->crclist             = 0;
     res->crcmatrix           = 0;
     res->crcstate            = 0;
+#if KERNEL_TIMING
+    kernel_times_reset(&res->ktimes);
+#endif
+#if CALC_STATS
+    res->cstats.hits   = 0;
+    res->cstats.misses = 0;
+    for (i = 0; i < 3; i++)
+        res->cstats.dispatch[i] = 0;
+#endif
 
     for (i = 0; i < iterations; i++)
     {
+        ROI_ITERATION_BEGIN(i);
         crc      = core_bench_list(res, 1);
         res->crc = crcu16(crc, res->crc);
         crc      = core_bench_list(res, -1);
         res->crc = crcu16(crc, res->crc);
         if (i == 0)
             res->crclist = res->crc;
+        ROI_ITERATION_END(i);
     }
+#if KERNEL_TIMING
+    kernel_switch(&res->ktimes, KERNEL_OTHER);
+#endif
+#if SCALE_SWEEP
+    res->done = portable_ticks();
+#endif
     return NULL;
 }
 
+#if KERNEL_TIMING
+static char *kernel_name[NUM_KERNELS]
+    = { "list find", "list sort", "matrix", "state", "other" };
+
+/* Function: report_kernel_times
+        Print the exclusive ticks of each kernel for one context, with cycles
+   and retired instructions where the platform can count them.
+*/
+static void
+report_kernel_times(ee_u16 ctx, kernel_times *kt)
+{
+    ee_u8 k;
+    for (k = 0; k < NUM_KERNELS; k++)
+    {
+        ee_printf("[%d]%-14s: %lu ticks",
+                  ctx,
+                  kernel_name[k],
+                  (long unsigned)kt->ticks[k]);
+        if (kt->cycles[k] != 0)
+            ee_printf(", %lu cycles", kt->cycles[k]);
+        if (kt->instret[k] != 0)
+            ee_printf(", %lu instret", kt->instret[k]);
+        ee_printf("\n");
+    }
+}
+#endif
+
+/* Function: check_known_crc
+        Compare the crcs of one context against the known output of the
+   <known_id> run, report any mismatch and return the number of errors.
+*/
+static ee_s16
+check_known_crc(core_results *res, ee_u16 ctx, ee_s16 known_id)
+{
+    res->err = 0;
+    if ((res->execs & ID_LIST) && (res->crclist != list_known_crc[known_id]))
+    {
+        ee_printf("[%u]ERROR! list crc 0x%04x - should be 0x%04x\n",
+                  ctx,
+                  res->crclist,
+                  list_known_crc[known_id]);
+        res->err++;
+    }
+    if ((res->execs & ID_MATRIX)
+        && (res->crcmatrix != matrix_known_crc[known_id]))
+    {
+        ee_printf("[%u]ERROR! matrix crc 0x%04x - should be 0x%04x\n",
+                  ctx,
+                  res->crcmatrix,
+                  matrix_known_crc[known_id]);
+        res->err++;
+    }
+    if ((res->execs & ID_STATE) && (res->crcstate != state_known_crc[known_id]))
+    {
+        ee_printf("[%u]ERROR! state crc 0x%04x - should be 0x%04x\n",
+                  ctx,
+                  res->crcstate,
+                  state_known_crc[known_id]);
+        res->err++;
+    }
+    return res->err;
+}
+
+#if SIZE_SWEEP || (REPORT_FORMAT != REPORT_TEXT) || TRIALS || MATRIX_SIMD \
+    || STATE_SIMD || LIST_CHASE || CALC_STATS || SCALE_SWEEP
+/* Function: div64
+        Return n / d with a shift and subtract division, as 64b division is
+   not available to the nolibc build on 32b targets.
+*/
+static unsigned long long
+div64(unsigned long long n, unsigned long long d)
+{
+    unsigned long long q = 0;
+    int                s = 0;
+
+    if (d == 0)
+        return 0;
+    while (!(d >> 63) && (d << 1) <= n)
+    {
+        d <<= 1;
+        s++;
+    }
+    for (; s >= 0; s--, d >>= 1)
+    {
+        q <<= 1;
+        if (n >= d)
+        {
+            n -= d;
+            q |= 1;
+        }
+    }
+    return q;
+}
+#endif
+
+#if SIZE_SWEEP || (REPORT_FORMAT != REPORT_TEXT) || TRIALS || MATRIX_SIMD \
+    || STATE_SIMD || LIST_CHASE || SCALE_SWEEP
+/* Function: ticks_per_sec
+        Rate of the port time base, recovered from <time_in_secs>.
+*/
+static ee_u32
+ticks_per_sec(void)
+{
+    return (ee_u32)((CORE_TICKS)1000000000
+                    / time_in_secs((CORE_TICKS)1000000000));
+}
+#endif
+
+#if SIZE_SWEEP || (REPORT_FORMAT != REPORT_TEXT) || TRIALS || MATRIX_SIMD \
+    || SCALE_SWEEP
+/* Function: iterations_rate
+        Return iterations per 1000 secs, so that the rate can be printed with
+   three decimals without floating point. The whole iterations per sec are
+   divided out first and the thousandths taken from the remainder, so that
+   nothing overflows 64 bits.
+*/
+static unsigned long long
+iterations_rate(ee_u32 iterations, CORE_TICKS ticks)
+{
+    unsigned long long n = (unsigned long long)iterations * ticks_per_sec();
+    unsigned long long q = div64(n, ticks);
+
+    return q * 1000 + div64((n - q * ticks) * 1000, ticks);
+}
+
+/* Function: rate_whole
+        Whole part of a rate given in thousandths, see <rate_frac>.
+*/
+static long unsigned
+rate_whole(unsigned long long rate)
+{
+    return (long unsigned)div64(rate, 1000);
+}
+
+/* Function: rate_frac
+        Thousandths of a rate given in thousandths, printed after
+   <rate_whole> with %03lu.
+*/
+static long unsigned
+rate_frac(unsigned long long rate)
+{
+    return (long unsigned)(rate - div64(rate, 1000) * 1000);
+}
+#endif
+
+#if CALC_STATS
+/* Function: report_calc_stats
+        Print the <calc_func> cache hits and misses of one context, and the
+   kernels run by the misses, in total and per iteration.
+*/
+static void
+report_calc_stats(ee_u16 ctx, core_results *res)
+{
+    calc_stats *cs    = &res->cstats;
+    ee_u32      calls = cs->hits + cs->misses;
+    ee_u32      hit_rate
+        = calls ? (ee_u32)div64((unsigned long long)cs->hits * 10000, calls)
+                : 0;
+    ee_u32 per_iter[3];
+    ee_u8  k;
+
+    for (k = 0; k < 3; k++)
+        per_iter[k] = (ee_u32)div64(
+            (unsigned long long)cs->dispatch[k] * 1000, res->iterations);
+    ee_printf("[%d]calc_func     : %lu hits, %lu misses (%lu.%02lu%% hits)\n",
+              ctx,
+              (long unsigned)cs->hits,
+              (long unsigned)cs->misses,
+              (long unsigned)(hit_rate / 100),
+              (long unsigned)(hit_rate % 100));
+    ee_printf("[%d]calc dispatch : state %lu, matrix %lu, none %lu\n",
+              ctx,
+              (long unsigned)cs->dispatch[CALC_STATE],
+              (long unsigned)cs->dispatch[CALC_MATRIX],
+              (long unsigned)cs->dispatch[CALC_NONE]);
+    ee_printf(
+        "[%d]per iteration : state %lu.%03lu, matrix %lu.%03lu, none "
+        "%lu.%03lu\n",
+        ctx,
+        (long unsigned)(per_iter[CALC_STATE] / 1000),
+        (long unsigned)(per_iter[CALC_STATE] % 1000),
+        (long unsigned)(per_iter[CALC_MATRIX] / 1000),
+        (long unsigned)(per_iter[CALC_MATRIX] % 1000),
+        (long unsigned)(per_iter[CALC_NONE] / 1000),
+        (long unsigned)(per_iter[CALC_NONE] % 1000));
+}
+#endif
+
+#if TRIALS
+typedef struct TRIAL_STATS_S
+{
+    unsigned long long min, median, mean, stddev, p95; /* per 1000 secs */
+    ee_u32 cv;                             /* tenths of a percent */
+    ee_u16 outliers;
+    ee_u16 median_trial;
+} trial_stats;
+static trial_stats trials;
+
+/* Function: isqrt64
+        Integer square root, bit by bit so that no division is needed.
+*/
+static ee_u32
+isqrt64(unsigned long long v)
+{
+    unsigned long long r = 0, b = 1ULL << 62;
+
+    while (b > v)
+        b >>= 2;
+    for (; b; b >>= 2)
+    {
+        if (v >= r + b)
+        {
+            v -= r + b;
+            r = (r >> 1) + b;
+        }
+        else
+            r >>= 1;
+    }
+    return (ee_u32)r;
+}
+
+/* Function: trial_statistics
+        Summarize the ticks of <TRIALS> runs of iterations each. Percentiles
+   use the nearest rank of the sorted rates.
+*/
+static void
+trial_statistics(CORE_TICKS *ticks, ee_u32 iterations, trial_stats *st)
+{
+    unsigned long long rate[TRIALS], r, q1, q3, lo, hi;
+    ee_u16             order[TRIALS];
+    ee_s16             i, j;
+    ee_u16             kept = 0;
+    unsigned long long sum = 0, sq = 0;
+
+    /* insertion sort of the rates, keeping the trial of each */
+    for (i = 0; i < TRIALS; i++)
+    {
+        r = iterations_rate(iterations, ticks[i]);
+        for (j = i; j > 0 && rate[j - 1] > r; j--)
+        {
+            rate[j]  = rate[j - 1];
+            order[j] = order[j - 1];
+        }
+        rate[j]  = r;
+        order[j] = i;
+    }
+    st->min          = rate[0];
+    st->median       = rate[(TRIALS - 1) / 2];
+    st->median_trial = order[(TRIALS - 1) / 2];
+    st->p95          = rate[(95 * TRIALS + 99) / 100 - 1];
+
+    /* Tukey fences at 1.5 IQR */
+    q1 = rate[(25 * TRIALS + 99) / 100 - 1];
+    q3 = rate[(75 * TRIALS + 99) / 100 - 1];
+    lo = (q1 > (q3 - q1) * 3 / 2) ? q1 - (q3 - q1) * 3 / 2 : 0;
+    hi = q3 + (q3 - q1) * 3 / 2;
+    for (i = 0; i < TRIALS; i++)
+    {
+        if (rate[i] < lo || rate[i] > hi)
+            continue;
+        sum += rate[i];
+        kept++;
+    }
+    st->outliers = TRIALS - kept;
+    st->mean     = div64(sum, kept);
+    for (i = 0; i < TRIALS; i++)
+    {
+        unsigned long long d;
+        if (rate[i] < lo || rate[i] > hi)
+            continue;
+        d = (rate[i] > st->mean) ? rate[i] - st->mean : st->mean - rate[i];
+        sq += d * d;
+    }
+    st->stddev = isqrt64(div64(sq, kept));
+    st->cv     = (ee_u32)div64(st->stddev * 1000, st->mean);
+}
+
+/* Function: report_trials
+        Print the trial statistics, and flag a noisy run.
+*/
+static void
+report_trials(trial_stats *st)
+{
+    static const char *name[5]
+        = { "Trials min", "Trials median", "Trials mean", "Trials stddev",
+            "Trials p95" };
+    unsigned long long v[5];
+    ee_u8              k;
+
+    v[0] = st->min;
+    v[1] = st->median;
+    v[2] = st->mean;
+    v[3] = st->stddev;
+    v[4] = st->p95;
+    ee_printf("Trials           : %d + %d warmup, %d outliers\n",
+              TRIALS,
+              TRIALS_WARMUP,
+              st->outliers);
+    for (k = 0; k < 5; k++)
+        ee_printf("%-17s: %lu.%03lu iterations/sec\n",
+                  name[k],
+                  rate_whole(v[k]),
+                  rate_frac(v[k]));
+    ee_printf("Trials CV        : %lu.%lu%%\n",
+              (long unsigned)(st->cv / 10),
+              (long unsigned)(st->cv % 10));
+    if (st->cv > TRIALS_MAX_CV)
+        ee_printf("WARNING! Trials CV is over %d.%d%%, the run is noisy!\n",
+                  TRIALS_MAX_CV / 10,
+                  TRIALS_MAX_CV % 10);
+}
+#endif
+
+#if SIZE_SWEEP || SIMPOINT
+/* seedcrc of the known runs, in the order of the tables above */
+static ee_u16 known_seedcrc[] = { (ee_u16)0x8a02,
+                                  (ee_u16)0x7b05,
+                                  (ee_u16)0x4eaf,
+                                  (ee_u16)0xe9f5,
+                                  (ee_u16)0x18f2 };
+#endif
+
+#if SIZE_SWEEP
+
+/* Function: size_sweep
+        Run the benchmark on growing working sets, from 2000 bytes up to
+   SIZE_SWEEP in half octave steps. Each size is initialized from scratch and
+   the iteration count doubled until the run takes at least a second.
+
+        Returns:
+        Number of errors.
+*/
+static ee_s16
+size_sweep(core_results *res)
+{
+    ee_u8 *            block;
+    ee_u32             size, step, blksize;
+    unsigned long long rate;
+    ee_u16             i, j, num_algorithms = 0;
+    ee_u16             seedcrc;
+    ee_s16             known_id, errors = 0;
+    CORE_TICKS         ticks;
+
+    block = (ee_u8 *)portable_malloc(SIZE_SWEEP);
+    if (block == NULL)
+    {
+        ee_printf("Cannot allocate %lu bytes for the size sweep!\n",
+                  (long unsigned)SIZE_SWEEP);
+        return 1;
+    }
+    for (i = 0; i < NUM_ALGORITHMS; i++)
+    {
+        if ((1 << (ee_u32)i) & res->execs)
+            num_algorithms++;
+    }
+    ee_printf("%12s %12s %10s %14s %6s\n",
+              "Size(bytes)",
+              "Iterations",
+              "Ticks",
+              "Iterations/Sec",
+              "Crc");
+    for (step = 0, size = 2000; size <= SIZE_SWEEP;
+         step++, size = (step & 1) ? 3000 << (step / 2) : 2000 << (step / 2))
+    {
+        blksize   = size / num_algorithms;
+        res->size = blksize;
+        for (i = 0, j = 0; i < NUM_ALGORITHMS; i++)
+        {
+            if ((1 << (ee_u32)i) & res->execs)
+                res->memblock[i + 1] = block + blksize * j++;
+        }
+        if (res->execs & ID_LIST)
+            res->list = core_list_init(blksize, res->memblock[1], res->seed1);
+        if (res->execs & ID_MATRIX)
+            core_init_matrix(blksize,
+                             res->memblock[2],
+                             (ee_s32)res->seed1 | (((ee_s32)res->seed2) << 16),
+                             &(res->mat));
+        if (res->execs & ID_STATE)
+            core_init_state(blksize, res->seed1, res->memblock[3]);
+
+        res->iterations = 1;
+        for (;;)
+        {
+            start_time();
+            iterate(res);
+            stop_time();
+            ticks = get_time();
+            if (time_in_secs(ticks) >= (secs_ret)1)
+                break;
+            res->iterations *= 2;
+        }
+        rate = iterations_rate(res->iterations, ticks);
+        ee_printf("%12lu %12lu %10lu %10lu.%03lu 0x%04x\n",
+                  (long unsigned)size,
+                  (long unsigned)res->iterations,
+                  (long unsigned)ticks,
+                  rate_whole(rate),
+                  rate_frac(rate),
+                  res->crc);
+
+        seedcrc = crc16(res->seed1, 0);
+        seedcrc = crc16(res->seed2, seedcrc);
+        seedcrc = crc16(res->seed3, seedcrc);
+        seedcrc = crc16(blksize, seedcrc);
+#if (CALC_CACHE == CALC_CACHE_TABLE)
+        seedcrc = crc16(CALC_CACHE_SIZE, seedcrc);
+#endif
+        for (known_id = 0; known_id < 5; known_id++)
+        {
+            if (seedcrc == known_seedcrc[known_id])
+            {
+                errors += check_known_crc(res, 0, known_id);
+                break;
+            }
+        }
+    }
+    portable_free(block);
+    return errors;
+}
+#endif
+
+#if SIMPOINT
+/* fingerprint of each iteration */
+typedef struct SIMPOINT_FP_S
+{
+    ee_u16        crc; /* running crc */
+    ee_u16        sig; /* crc of the iteration alone */
+    unsigned long cycles;
+    unsigned long instret;
+} simpoint_fp;
+static simpoint_fp simpoint_fps[SIMPOINT];
+
+/* Function: simpoint_period
+        Find a period p such that the iterations repeat with period p from
+   iteration s to the end. The periodic part must hold two periods and half
+   of the run at least, and the earliest s wins, then the smallest p.
+   Iterations match on their crc and retired instructions, the cycles are
+   too noisy.
+
+        Returns:
+        The period, 0 if there is none, and the first iteration of the
+   periodic part in start.
+*/
+static ee_u32
+simpoint_period(simpoint_fp *fp, ee_u32 n, ee_u32 *start)
+{
+    ee_u32 p, s, period = 0;
+
+    *start = n;
+    for (p = 1; 2 * p <= n; p++)
+    {
+        s = n - p;
+        while (s > 0 && fp[s - 1].sig == fp[s - 1 + p].sig
+               && fp[s - 1].instret == fp[s - 1 + p].instret)
+            s--;
+        if ((n - s >= 2 * p) && (2 * (n - s) >= n) && (s < *start))
+        {
+            *start = s;
+            period = p;
+        }
+    }
+    return period;
+}
+
+/* Function: simpoint
+        Run exactly <SIMPOINT> iterations of the first context, recording a
+   fingerprint of each, then print the fingerprints and the period found.
+   The loop is the one of <iterate>, between start_time and stop_time so that
+   the region markers apply.
+
+        Returns:
+        Number of errors.
+*/
+static ee_s16
+simpoint(core_results *res)
+{
+    ee_u32        i, period, start = 0;
+    ee_u16        crc, sig, seedcrc;
+    ee_s16        known_id, errors = 0;
+    unsigned long cycles, instret;
+
+    res->crc       = 0;
+    res->crclist   = 0;
+    res->crcmatrix = 0;
+    res->crcstate  = 0;
+#if KERNEL_TIMING
+    kernel_times_reset(&res->ktimes);
+#endif
+    start_time();
+    for (i = 0; i < SIMPOINT; i++)
+    {
+        ROI_ITERATION_BEGIN(i);
+        cycles   = portable_cycles();
+        instret  = portable_instret();
+        crc      = core_bench_list(res, 1);
+        res->crc = crcu16(crc, res->crc);
+        sig      = crcu16(crc, 0);
+        crc      = core_bench_list(res, -1);
+        res->crc = crcu16(crc, res->crc);
+        sig      = crcu16(crc, sig);
+        simpoint_fps[i].instret = portable_instret() - instret;
+        simpoint_fps[i].cycles  = portable_cycles() - cycles;
+        simpoint_fps[i].crc     = res->crc;
+        simpoint_fps[i].sig     = sig;
+        if (i == 0)
+            res->crclist = res->crc;
+        ROI_ITERATION_END(i);
+    }
+    stop_time();
+
+    ee_printf("Simpoint         : %lu iterations, %lu list benchmark calls\n",
+              (long unsigned)SIMPOINT,
+              (long unsigned)SIMPOINT * 2);
+    ee_printf("%8s %6s %6s %12s %12s\n",
+              "Iter",
+              "Crc",
+              "Sig",
+              "Cycles",
+              "Instret");
+    for (i = 0; i < SIMPOINT; i++)
+        ee_printf("%8lu 0x%04x 0x%04x %12lu %12lu\n",
+                  (long unsigned)i,
+                  simpoint_fps[i].crc,
+                  simpoint_fps[i].sig,
+                  simpoint_fps[i].cycles,
+                  simpoint_fps[i].instret);
+    period = simpoint_period(simpoint_fps, SIMPOINT, &start);
+    if (period)
+        ee_printf(
+            "Simpoint period  : %lu from iteration %lu, window %lu-%lu is "
+            "%lu.%lu%% of the work\n",
+            (long unsigned)period,
+            (long unsigned)start,
+            (long unsigned)start,
+            (long unsigned)(start + period - 1),
+            (long unsigned)(period * 1000 / SIMPOINT / 10),
+            (long unsigned)(period * 1000 / SIMPOINT % 10));
+    else
+        ee_printf("Simpoint period  : none in %lu iterations\n",
+                  (long unsigned)SIMPOINT);
+    ee_printf("[0]crcfinal      : 0x%04x\n", res->crc);
+
+    seedcrc = crc16(res->seed1, 0);
+    seedcrc = crc16(res->seed2, seedcrc);
+    seedcrc = crc16(res->seed3, seedcrc);
+    seedcrc = crc16(res->size, seedcrc);
+#if MATRIX_N
+    seedcrc = crc16(MATRIX_N, seedcrc);
+#endif
+#if (CALC_CACHE == CALC_CACHE_TABLE)
+    seedcrc = crc16(CALC_CACHE_SIZE, seedcrc);
+#endif
+    for (known_id = 0; known_id < 5; known_id++)
+    {
+        if (seedcrc == known_seedcrc[known_id])
+        {
+            errors += check_known_crc(res, 0, known_id);
+            break;
+        }
+    }
+    return errors;
+}
+#endif
+
 #if (SEED_METHOD == SEED_ARG)
 ee_s32 get_seed_args(int i, int argc, char *argv[]);
 #define get_seed(x)    (ee_s16) get_seed_args(x, argc, argv)
@@ -82,9 +664,678 @@ ee_s32 get_seed_32(int i);
 #endif
 
 #if (MEM_METHOD == MEM_STATIC)
-ee_u8 static_memblk[TOTAL_DATA_SIZE];
+#if NUMA_PLACE
+/* one block per context on its own pages, so each can be bound to a node */
+#define STATIC_MEMBLK_STRIDE ((TOTAL_DATA_SIZE + 4095) & ~4095)
+ee_u8 static_memblk[STATIC_MEMBLK_STRIDE * MULTITHREAD]
+    __attribute__((aligned(4096)));
+#else
+/* one block per context, padded to whole 64 byte lines */
+#define STATIC_MEMBLK_STRIDE ((TOTAL_DATA_SIZE + 63) & ~63)
+ee_u8 static_memblk[STATIC_MEMBLK_STRIDE * MULTITHREAD];
+#endif
+#endif
+#if MATRIX_N
+#if (8 * MATRIX_N * MATRIX_N + 16) > 0x7fffffff
+#error "MATRIX_N too large, the matrix block size must fit in 31 bits"
+#endif
+/* core_init_matrix takes the largest N with 8 * N * N below the block size,
+ * the rest covers the alignment of A and C */
+#define MATRIX_BLKSIZE ((ee_size_t)8 * MATRIX_N * MATRIX_N + 16)
+#if NUMA_PLACE
+/* on pages of its own as well, see static_memblk */
+#define MATRIX_STRIDE ((MATRIX_BLKSIZE + 4095) & ~4095)
+ee_u8 matrix_memblk[MATRIX_STRIDE * MULTITHREAD] __attribute__((aligned(4096)));
+#else
+#define MATRIX_STRIDE MATRIX_BLKSIZE
+ee_u8 matrix_memblk[MATRIX_STRIDE * MULTITHREAD];
+#endif
 #endif
 char *mem_name[3] = { "Static", "Heap", "Stack" };
+char *crc_name[4] = { "Bitwise", "Table", "Slicing-by-4", "CLMUL" };
+char *matmul_name[3] = { "Naive", "Blocked", "Transposed B" };
+char *state_name[2]  = { "Switch", "Table" };
+char *list_name[2]   = { "Pointer cells", "Arrays, 16b links" };
+char *list_sort_name[2] = { "Merge", "Natural runs" };
+#if CORE_VARIANT && HAS_FLOAT
+/* Function: print_variant
+        Print the kernel options that make the build a variant, see
+   <CORE_VARIANT>, for its score line.
+*/
+static void
+print_variant(void)
+{
+    const char *sep = "";
+#if (CRC_METHOD != CRC_BITWISE)
+    ee_printf("%sCRC %s", sep, crc_name[CRC_METHOD]);
+    sep = ", ";
+#endif
+#if (MATMUL_METHOD != MATMUL_NAIVE)
+    ee_printf("%s%s matmul", sep, matmul_name[MATMUL_METHOD]);
+    sep = ", ";
+#endif
+#if MATRIX_N
+    ee_printf("%sN=%d matrix", sep, MATRIX_N);
+    sep = ", ";
+#endif
+#if LIST_SOA
+    ee_printf("%s%s list", sep, list_name[LIST_SOA]);
+    sep = ", ";
+#endif
+#if (LIST_SORT != LIST_SORT_MERGE)
+    ee_printf("%s%s list sort", sep, list_sort_name[LIST_SORT]);
+    sep = ", ";
+#endif
+#if (CALC_CACHE != CALC_CACHE_INPLACE)
+    ee_printf("%sTable calc cache", sep);
+    sep = ", ";
+#endif
+#if (STATE_ENGINE != STATE_SWITCH)
+    ee_printf("%s%s state machine", sep, state_name[STATE_ENGINE]);
+    sep = ", ";
+#endif
+#if KERNEL_TIMING
+    ee_printf("%skernel timing", sep);
+#endif
+}
+#endif
+/* Function: run_contexts
+        Run <iterate> on all contexts.
+*/
+static void
+run_contexts(core_results *results)
+{
+#if (MULTITHREAD > 1)
+    ee_u16 i;
+
+    for (i = 0; i < default_num_contexts; i++)
+    {
+        results[i].iterations = results[0].iterations;
+        results[i].execs      = results[0].execs;
+        core_start_parallel(&results[i]);
+    }
+    for (i = 0; i < default_num_contexts; i++)
+    {
+        core_stop_parallel(&results[i]);
+    }
+#else
+    iterate(&results[0]);
+#endif
+}
+
+/* Function: timed_run
+        Run <iterate> on all contexts inside start_time/stop_time, and return
+   the ticks taken.
+*/
+static CORE_TICKS
+timed_run(core_results *results)
+{
+    start_time();
+    run_contexts(results);
+    stop_time();
+    return get_time();
+}
+
+#if MATRIX_SIMD || SCALE_SWEEP || TRIALS
+/* Function: clocked_run
+        As <timed_run>, for the runs besides the reported one: only the clock
+   is read, so the perf counters and ROI markers of start_time/stop_time
+   stay with the reported run.
+*/
+static CORE_TICKS
+clocked_run(core_results *results)
+{
+    portable_start_clock();
+    run_contexts(results);
+    portable_stop_clock();
+    return get_time();
+}
+#endif
+
+#if MATRIX_SIMD
+/* iterations and ticks of the matrix check runs, scalar then vector */
+static ee_u32     simd_iterations;
+static CORE_TICKS simd_ticks[2];
+
+/* Function: check_simd
+        After the timed run, run a tenth of its iterations with the vector
+   kernels, then as many with the scalar ones, each timed on its own. The
+   vector kernels must reproduce the crcs of the scalar run. The results of
+   the timed run are put back afterwards. Report the vector rate next to the
+   scalar one, and return the number of errors.
+*/
+static ee_s16
+check_simd(core_results *results)
+{
+    static core_results saved[MULTITHREAD];
+    static ee_u16       crc[MULTITHREAD], crcmatrix[MULTITHREAD];
+    unsigned long long  scalar, vector;
+    ee_u32              iterations, speedup;
+    ee_s16              errors = 0;
+    ee_u16              i;
+
+    for (i = 0; i < default_num_contexts; i++)
+        saved[i] = results[i];
+    simd_iterations = results[0].iterations / 10;
+    if (simd_iterations == 0)
+        simd_iterations = 1;
+    results[0].iterations = simd_iterations;
+    matrix_simd           = 1;
+    simd_ticks[1]         = clocked_run(results);
+    for (i = 0; i < default_num_contexts; i++)
+    {
+        crc[i]       = results[i].crc;
+        crcmatrix[i] = results[i].crcmatrix;
+    }
+    matrix_simd   = 0;
+    simd_ticks[0] = clocked_run(results);
+    for (i = 0; i < default_num_contexts; i++)
+    {
+        if (crcmatrix[i] != results[i].crcmatrix || crc[i] != results[i].crc)
+        {
+            ee_printf(
+                "[%u]ERROR! vector matrix crc 0x%04x/0x%04x - should be "
+                "0x%04x/0x%04x\n",
+                i,
+                crcmatrix[i],
+                crc[i],
+                results[i].crcmatrix,
+                results[i].crc);
+            errors++;
+        }
+        results[i] = saved[i];
+    }
+    iterations = default_num_contexts * simd_iterations;
+    scalar     = iterations_rate(iterations, simd_ticks[0]);
+    vector     = iterations_rate(iterations, simd_ticks[1]);
+    speedup    = (ee_u32)div64(vector * 100, scalar);
+    ee_printf("Scalar Iter/Sec  : %lu.%03lu\n",
+              rate_whole(scalar),
+              rate_frac(scalar));
+    ee_printf("Vector Iter/Sec  : %lu.%03lu (%s matrix kernels, %lu.%02lux)\n",
+              rate_whole(vector),
+              rate_frac(vector),
+              matrix_simd_isa,
+              (long unsigned)(speedup / 100),
+              (long unsigned)(speedup % 100));
+    return errors;
+}
+#endif
+
+#if STATE_SIMD
+/* state input scanned per sec, in KB, scalar then vector */
+static ee_u32 state_scan_rate[2];
+
+/* Function: check_state_scan
+        Time the scan of the state input alone, scalar then vector, over the
+   input of the first context, until each takes at least a tenth of a second.
+   Both scans must agree on the counts. Report the parsing rates, and return
+   the number of errors.
+*/
+static ee_s16
+check_state_scan(core_results *res)
+{
+    CORE_TICKS ticks;
+    ee_u32     bytes = 0, passes, speedup;
+    ee_u16     crc[2];
+    ee_u8      vector;
+
+    for (vector = 0; vector < 2; vector++)
+    {
+        passes = 1;
+        do
+        {
+            passes *= 2;
+            portable_start_clock();
+            crc[vector] = core_scan_state(
+                res->size, res->memblock[3], passes, vector, &bytes);
+            portable_stop_clock();
+            ticks = get_time();
+        } while (ticks < ticks_per_sec() / 10);
+        state_scan_rate[vector] = (ee_u32)div64(
+            (unsigned long long)bytes * passes * ticks_per_sec(),
+            (unsigned long long)ticks * 1000);
+    }
+    speedup = (ee_u32)div64((unsigned long long)state_scan_rate[1] * 100,
+                            state_scan_rate[0]);
+    ee_printf("State scan MB/Sec: %lu.%03lu (%s tokenizer, %lu.%02lux)\n",
+              (long unsigned)(state_scan_rate[1] / 1000),
+              (long unsigned)(state_scan_rate[1] % 1000),
+              state_simd_isa,
+              (long unsigned)(speedup / 100),
+              (long unsigned)(speedup % 100));
+    if (crc[0] != crc[1])
+    {
+        ee_printf("ERROR! vector state scan crc 0x%04x - should be 0x%04x\n",
+                  crc[1],
+                  crc[0]);
+        return 1;
+    }
+    return 0;
+}
+#endif
+
+#if LIST_CHASE
+/* time per hop of the find and reverse walks, in picoseconds */
+static ee_u32 list_chase_ps[2];
+
+/* Function: list_chase
+        Time <core_list_chase> over a LIST_CHASE bytes arena, find then
+   reverse, each until it takes at least half a second, and report the time
+   per hop.
+
+        Returns:
+        Number of errors.
+*/
+static ee_s16
+list_chase(core_results *res)
+{
+    static const char *op_name[2] = { "Find", "Reverse" };
+    ee_u8 *            arena;
+    list_head *        list;
+    ee_u32             cells, passes, hops, found;
+    ee_u8              op;
+    ee_s16             errors = 0;
+    CORE_TICKS         ticks;
+
+    arena = (ee_u8 *)portable_malloc(LIST_CHASE);
+    if (arena == NULL)
+    {
+        ee_printf("ERROR! cannot allocate %lu bytes for the list chase!\n",
+                  (long unsigned)LIST_CHASE);
+        return 1;
+    }
+    list = core_list_chase_init(
+        arena, LIST_CHASE, LIST_CHASE_STRIDE, res->seed1, &cells);
+    ee_printf("List chase       : %lu bytes, %lu cells, %u byte stride\n",
+              (long unsigned)LIST_CHASE,
+              (long unsigned)cells,
+              LIST_CHASE_STRIDE);
+    for (op = 0; op < 2; op++)
+    {
+        passes = 1;
+        for (;;)
+        {
+            portable_start_clock();
+            found = core_list_chase(&list, passes, op);
+            portable_stop_clock();
+            ticks = get_time();
+            if (ticks >= ticks_per_sec() / 2)
+                break;
+            passes *= 2;
+        }
+        /* every walk must go through all the cells */
+        hops = core_list_chase_hops(list);
+        if ((found != 0) || (hops != cells))
+        {
+            ee_printf("ERROR! list chase %s walked %lu of %lu cells, %lu "
+                      "finds stopped early\n",
+                      op_name[op],
+                      (long unsigned)hops,
+                      (long unsigned)cells,
+                      (long unsigned)found);
+            errors++;
+        }
+        list_chase_ps[op] = (ee_u32)div64(
+            div64((unsigned long long)ticks * 1000000000, ticks_per_sec())
+                * 1000,
+            (unsigned long long)passes * cells);
+        ee_printf("%-7s ns/hop   : %lu.%03lu\n",
+                  op_name[op],
+                  (long unsigned)(list_chase_ps[op] / 1000),
+                  (long unsigned)(list_chase_ps[op] % 1000));
+    }
+    portable_free(arena);
+    return errors;
+}
+#endif
+
+#if SCALE_SWEEP
+/* one entry per context count of the sweep */
+typedef struct SCALE_STEP_S
+{
+    ee_u32     contexts;
+    CORE_TICKS ticks;
+    ee_u32     efficiency; /* permille of contexts times the 1 context rate */
+    ee_u32     spread;     /* permille of the last context end */
+} scale_step;
+static scale_step scale_steps[MULTITHREAD];
+static ee_u16     scale_count;
+
+/* Function: scale_sweep
+        Repeat the timed run on 1, 2, 4 ... contexts (every count with
+   SCALE_ALL) up to <default_num_contexts>, each context running the
+   iterations of the timed run. The spread is the gap between the first and
+   the last context to finish, relative to the last one. Each context must
+   reproduce the CRC of the timed run.
+
+        Returns:
+        Number of errors.
+*/
+static ee_s16
+scale_sweep(core_results *results)
+{
+    ee_u32             full = default_num_contexts, n, i;
+    unsigned long long rate, base = 0;
+    ee_u16             crc = results[0].crc;
+    CORE_TICKS         first, last;
+    scale_step *       st;
+    ee_s16             errors = 0;
+
+    ee_printf("%8s %14s %14s %10s %8s\n",
+              "Contexts",
+              "Iterations/Sec",
+              "Per context",
+              "Efficiency",
+              "Spread");
+    scale_count = 0;
+    for (n = 1; n <= full;)
+    {
+        default_num_contexts = n;
+        st                   = &scale_steps[scale_count++];
+        st->contexts         = n;
+        st->ticks            = clocked_run(results);
+        first = last = results[0].done;
+        for (i = 0; i < n; i++)
+        {
+            if (results[i].done < first)
+                first = results[i].done;
+            if (results[i].done > last)
+                last = results[i].done;
+            if (results[i].crc != crc)
+            {
+                ee_printf("[%u]ERROR! crcfinal was 0x%04x with %u contexts, "
+                          "0x%04x in the timed run\n",
+                          i,
+                          results[i].crc,
+                          n,
+                          crc);
+                errors++;
+            }
+        }
+        rate = iterations_rate(n * results[0].iterations, st->ticks);
+        if (n == 1)
+            base = rate;
+        st->efficiency
+            = (ee_u32)div64(rate * 1000, (unsigned long long)n * base);
+        st->spread = (ee_u32)div64((unsigned long long)(last - first) * 1000,
+                                   last);
+        ee_printf("%8u %10lu.%03lu %10lu.%03lu %7lu.%lu%% %5lu.%lu%%\n",
+                  n,
+                  rate_whole(rate),
+                  rate_frac(rate),
+                  rate_whole(div64(rate, n)),
+                  rate_frac(div64(rate, n)),
+                  (long unsigned)(st->efficiency / 10),
+                  (long unsigned)(st->efficiency % 10),
+                  (long unsigned)(st->spread / 10),
+                  (long unsigned)(st->spread % 10));
+        if ((SCALE_SWEEP == SCALE_ALL) || (n == full))
+            n++;
+        else
+            n = (n * 2 < full) ? n * 2 : full;
+    }
+    default_num_contexts = full;
+    return errors;
+}
+#endif
+
+#if (REPORT_FORMAT != REPORT_TEXT)
+static char *known_run_name[5] = { "6k performance",
+                                   "6k validation",
+                                   "profile generation",
+                                   "2K performance",
+                                   "2K validation" };
+#if KERNEL_TIMING
+static char *kernel_key[NUM_KERNELS]
+    = { "list_find", "list_sort", "matrix", "state", "other" };
+#endif
+#if USE_PERF
+static char *perf_key[NUM_PERF_EVENTS]
+    = { "cycles",     "instructions", "branch_misses",
+        "l1d_misses", "llc_misses",   "dtlb_misses" };
+#endif
+
+/* set during the CSV header pass, which prints the keys only */
+static ee_u8 report_keys;
+static ee_u8 report_count;
+
+/* Function: report_key
+        Start a field named key[_sub][_ctx]. Returns 1 if the value should
+   follow, 0 in the CSV header pass.
+*/
+static ee_u8
+report_key(const char *key, const char *sub, ee_s16 ctx)
+{
+    if (report_count++)
+        ee_printf(",");
+    if ((REPORT_FORMAT == REPORT_CSV) && !report_keys)
+        return 1;
+    if (REPORT_FORMAT == REPORT_JSON)
+        ee_printf("\"");
+    ee_printf("%s", key);
+    if (sub)
+        ee_printf("_%s", sub);
+    if (ctx >= 0)
+        ee_printf("_%d", ctx);
+    if (REPORT_FORMAT == REPORT_CSV)
+        return 0;
+    ee_printf("\":");
+    return 1;
+}
+static void
+report_uint(const char *key, const char *sub, ee_s16 ctx, ee_u32 v)
+{
+    if (report_key(key, sub, ctx))
+        ee_printf("%lu", (long unsigned)v);
+}
+/* 64b values such as CORE_TICKS, converted with div64 as there is no %llu
+ * in the nolibc build */
+static void
+report_u64(const char *key, const char *sub, ee_s16 ctx, unsigned long long v)
+{
+    char buf[21];
+    int  i = sizeof(buf) - 1;
+
+    buf[i] = 0;
+    do
+    {
+        unsigned long long q = div64(v, 10);
+        buf[--i]             = (char)('0' + (v - q * 10));
+        v                    = q;
+    } while (v);
+    if (report_key(key, sub, ctx))
+        ee_printf("%s", buf + i);
+}
+static void
+report_hex(const char *key, const char *sub, ee_s16 ctx, ee_u16 v)
+{
+    if (report_key(key, sub, ctx))
+        ee_printf("\"0x%04x\"", v);
+}
+#if USE_PERF
+/* v is printed as is, NULL for a missing value */
+static void
+report_raw(const char *key, const char *sub, ee_s16 ctx, const char *v)
+{
+    if (report_key(key, sub, ctx))
+        ee_printf("%s", v ? v : ((REPORT_FORMAT == REPORT_JSON) ? "null" : ""));
+}
+#endif
+/* rate given in thousandths, printed with three decimals */
+static void
+report_rate(const char *key, unsigned long long rate)
+{
+    if (report_key(key, NULL, -1))
+        ee_printf("%lu.%03lu", rate_whole(rate), rate_frac(rate));
+}
+/* quoted, with '"' escaped as \" in JSON and as "" in CSV */
+static void
+report_str(const char *key, const char *s)
+{
+    if (!report_key(key, NULL, -1))
+        return;
+    ee_printf("\"");
+    for (; *s; s++)
+    {
+        if (*s == '"')
+            ee_printf((REPORT_FORMAT == REPORT_JSON) ? "\\\"" : "\"\"");
+        else if (*s == '\\' && (REPORT_FORMAT == REPORT_JSON))
+            ee_printf("\\\\");
+        else if ((ee_u8)*s >= ' ')
+            ee_printf("%c", *s);
+    }
+    ee_printf("\"");
+}
+
+/* Function: report_record
+        Print the run as one JSON object, or as a CSV header and line.
+   Everything the text report shows is included, as integers: seeds, size,
+   iterations, ticks, the rate in thousandths, per context crcs, validation
+   status, build strings and the kernel and hardware counters when enabled.
+*/
+static void
+report_record(core_results *res,
+              CORE_TICKS    ticks,
+              ee_u16        seedcrc,
+              ee_s16        known_id,
+              ee_s16        errors)
+{
+    ee_u32             iterations = default_num_contexts * res[0].iterations;
+    unsigned long long rate       = iterations_rate(iterations, ticks);
+    ee_u8              pass;
+    ee_s16             i;
+#if KERNEL_TIMING
+    ee_u8 k;
+#endif
+#if USE_PERF
+    char perf_str[24];
+#endif
+
+    for (pass = (REPORT_FORMAT == REPORT_CSV) ? 0 : 1; pass < 2; pass++)
+    {
+        report_keys  = (pass == 0);
+        report_count = 0;
+        if (REPORT_FORMAT == REPORT_JSON)
+            ee_printf("{");
+        report_uint("seed1", NULL, -1, (ee_u16)res[0].seed1);
+        report_uint("seed2", NULL, -1, (ee_u16)res[0].seed2);
+        report_uint("seed3", NULL, -1, (ee_u16)res[0].seed3);
+        report_uint("size", NULL, -1, res[0].size);
+        report_uint("execs", NULL, -1, res[0].execs);
+        report_uint("contexts", NULL, -1, default_num_contexts);
+        report_uint("iterations", NULL, -1, iterations);
+        report_u64("ticks", NULL, -1, ticks);
+        report_uint("ticks_per_sec", NULL, -1, ticks_per_sec());
+        report_rate("iterations_per_sec", rate);
+        report_hex("seedcrc", NULL, -1, seedcrc);
+        report_str("run", (known_id >= 0) ? known_run_name[known_id] : "");
+        report_str("score", CORE_VARIANT ? "variant" : "reference");
+        report_str("validation",
+                   (errors == 0) ? "valid" : (errors > 0) ? "errors" : "unknown");
+        report_uint("errors", NULL, -1, (errors > 0) ? errors : 0);
+        report_str("compiler_version", COMPILER_VERSION);
+        report_str("compiler_flags", COMPILER_FLAGS);
+#if defined(MEM_LOCATION) && !defined(MEM_LOCATION_UNSPEC)
+        report_str("memory_location", MEM_LOCATION);
+#else
+        report_str("memory_location", mem_name[MEM_METHOD]);
+#endif
+#if (MULTITHREAD > 1)
+        report_str("parallel", PARALLEL_METHOD);
+#endif
+        report_str("crc_engine", crc_name[CRC_METHOD]);
+        report_str("state_engine", state_name[STATE_ENGINE]);
+        report_str("list_layout", list_name[LIST_SOA]);
+        report_str("list_sort", list_sort_name[LIST_SORT]);
+        report_str("calc_cache",
+                   (CALC_CACHE == CALC_CACHE_TABLE) ? "Table" : "In place");
+#if LIST_CHASE
+        report_uint("list_chase_bytes", NULL, -1, LIST_CHASE);
+        report_uint("list_chase_stride", NULL, -1, LIST_CHASE_STRIDE);
+        report_rate("list_chase_find_ns_per_hop", list_chase_ps[0]);
+        report_rate("list_chase_reverse_ns_per_hop", list_chase_ps[1]);
+#endif
+#if STATE_SIMD
+        report_str("state_simd", state_simd_isa);
+        report_rate("state_scan_mb_per_sec", state_scan_rate[1]);
+        report_rate("scalar_state_scan_mb_per_sec", state_scan_rate[0]);
+#endif
+        for (i = 0; i < (ee_s16)default_num_contexts; i++)
+        {
+            report_hex("crclist", NULL, i, res[i].crclist);
+            report_hex("crcmatrix", NULL, i, res[i].crcmatrix);
+            report_hex("crcstate", NULL, i, res[i].crcstate);
+            report_hex("crcfinal", NULL, i, res[i].crc);
+#if CALC_STATS
+            report_uint("calc_hits", NULL, i, res[i].cstats.hits);
+            report_uint("calc_misses", NULL, i, res[i].cstats.misses);
+            report_uint("calc_state",
+                        NULL,
+                        i,
+                        res[i].cstats.dispatch[CALC_STATE]);
+            report_uint("calc_matrix",
+                        NULL,
+                        i,
+                        res[i].cstats.dispatch[CALC_MATRIX]);
+            report_uint(
+                "calc_none", NULL, i, res[i].cstats.dispatch[CALC_NONE]);
+#endif
+#if KERNEL_TIMING
+            for (k = 0; k < NUM_KERNELS; k++)
+                report_u64("ticks", kernel_key[k], i, res[i].ktimes.ticks[k]);
+            for (k = 0; k < NUM_KERNELS; k++)
+                report_u64("cycles", kernel_key[k], i, res[i].ktimes.cycles[k]);
+            for (k = 0; k < NUM_KERNELS; k++)
+                report_u64(
+                    "instret", kernel_key[k], i, res[i].ktimes.instret[k]);
+#endif
+        }
+#if MATRIX_SIMD
+        report_str("matrix_simd", matrix_simd_isa);
+        report_rate("scalar_check_iterations_per_sec",
+                    iterations_rate(default_num_contexts * simd_iterations,
+                                    simd_ticks[0]));
+        report_rate("vector_iterations_per_sec",
+                    iterations_rate(default_num_contexts * simd_iterations,
+                                    simd_ticks[1]));
+#endif
+#if TRIALS
+        report_uint("trials", NULL, -1, TRIALS);
+        report_uint("trials_warmup", NULL, -1, TRIALS_WARMUP);
+        report_uint("trials_outliers", NULL, -1, trials.outliers);
+        report_rate("trials_min", trials.min);
+        report_rate("trials_median", trials.median);
+        report_rate("trials_mean", trials.mean);
+        report_rate("trials_stddev", trials.stddev);
+        report_rate("trials_p95", trials.p95);
+        report_uint("trials_cv_permille", NULL, -1, trials.cv);
+        report_uint("trials_noisy", NULL, -1, trials.cv > TRIALS_MAX_CV);
+#endif
+#if SCALE_SWEEP
+        for (i = 0; i < (ee_s16)scale_count; i++)
+        {
+            report_uint("scale_contexts", NULL, i, scale_steps[i].contexts);
+            report_u64("scale_ticks", NULL, i, scale_steps[i].ticks);
+            report_uint("scale_efficiency_permille",
+                        NULL,
+                        i,
+                        scale_steps[i].efficiency);
+            report_uint(
+                "scale_spread_permille", NULL, i, scale_steps[i].spread);
+        }
+#endif
+#if USE_PERF
+        for (i = 0; i < NUM_PERF_EVENTS; i++)
+            report_raw("perf",
+                       perf_key[i],
+                       -1,
+                       (perf_counter_read(i, perf_str) == 0) ? perf_str : NULL);
+#endif
+        ee_printf((REPORT_FORMAT == REPORT_JSON) ? "}\n" : "\n");
+    }
+}
+#endif
 /* Function: main
         Main entry routine for the benchmark.
         This function is responsible for the following steps:
@@ -120,11 +1371,18 @@ main(int argc, char *argv[])
     ee_u16       seedcrc = 0;
     CORE_TICKS   total_time;
     core_results results[MULTITHREAD];
+#if TRIALS
+    ee_u16     trial;
+    CORE_TICKS trial_ticks[TRIALS];
+#endif
 #if (MEM_METHOD == MEM_STACK)
     ee_u8 stack_memblock[TOTAL_DATA_SIZE * MULTITHREAD];
 #endif
     /* first call any initializations needed */
     portable_init(&(results[0].port), &argc, argv);
+#if (CRC_METHOD != CRC_BITWISE)
+    crc_init();
+#endif
     /* First some checks to make sure benchmark will run ok */
     if (sizeof(struct list_head_s) > 128)
     {
@@ -158,13 +1416,25 @@ main(int argc, char *argv[])
         results[0].seed2 = 0x3415;
         results[0].seed3 = 0x66;
     }
-#if (MEM_METHOD == MEM_STATIC)
-    results[0].memblock[0] = (void *)static_memblk;
-    results[0].size        = TOTAL_DATA_SIZE;
-    results[0].err         = 0;
-#if (MULTITHREAD > 1)
-#error "Cannot use a static data area with multiple contexts!"
+#if SIZE_SWEEP
+    total_errors = size_sweep(&results[0]);
+    if (total_errors > 0)
+        ee_printf("Errors detected\n");
+    portable_fini(&(results[0].port));
+    return MAIN_RETURN_VAL;
 #endif
+#if (MEM_METHOD == MEM_STATIC)
+    for (i = 0; i < MULTITHREAD; i++)
+    {
+        results[i].memblock[0]
+            = (void *)(static_memblk + i * STATIC_MEMBLK_STRIDE);
+        results[i].size  = TOTAL_DATA_SIZE;
+        results[i].seed1 = results[0].seed1;
+        results[i].seed2 = results[0].seed2;
+        results[i].seed3 = results[0].seed3;
+        results[i].err   = 0;
+        results[i].execs = results[0].execs;
+    }
 #elif (MEM_METHOD == MEM_MALLOC)
     for (i = 0; i < MULTITHREAD; i++)
     {
@@ -193,6 +1463,15 @@ for (i = 0; i < MULTITHREAD; i++)
 }
 #else
 #error "Please define a way to initialize a memory block."
+#endif
+#if (MULTITHREAD > 1) && NUMA_PLACE
+    /* record the whole blocks before they are split between the kernels */
+    for (i = 0; i < MULTITHREAD; i++)
+    {
+        results[i].port.place_block[0] = results[i].memblock[0];
+        results[i].port.place_size[0]  = results[i].size;
+        results[i].port.place_size[1]  = 0;
+    }
 #endif
     /* Data init */
     /* Find out how space much we have based on number of algorithms */
@@ -225,11 +1504,24 @@ for (i = 0; i < MULTITHREAD; i++)
         }
         if (results[i].execs & ID_MATRIX)
         {
+#if MATRIX_N
+            results[i].memblock[2] = matrix_memblk + i * MATRIX_STRIDE;
+#if (MULTITHREAD > 1) && NUMA_PLACE
+            results[i].port.place_block[1] = results[i].memblock[2];
+            results[i].port.place_size[1]  = (ee_u32)MATRIX_BLKSIZE;
+#endif
+            core_init_matrix((ee_u32)MATRIX_BLKSIZE,
+                             results[i].memblock[2],
+                             (ee_s32)results[i].seed1
+                                 | (((ee_s32)results[i].seed2) << 16),
+                             &(results[i].mat));
+#else
             core_init_matrix(results[0].size,
                              results[i].memblock[2],
                              (ee_s32)results[i].seed1
                                  | (((ee_s32)results[i].seed2) << 16),
                              &(results[i].mat));
+#endif
         }
         if (results[i].execs & ID_STATE)
         {
@@ -238,6 +1530,13 @@ for (i = 0; i < MULTITHREAD; i++)
         }
     }
 
+#if SIMPOINT
+    total_errors = simpoint(&results[0]);
+    if (total_errors > 0)
+        ee_printf("Errors detected\n");
+    portable_fini(&(results[0].port));
+    return MAIN_RETURN_VAL;
+#endif
     /* automatically determine number of iterations if not set */
     if (results[0].iterations == 0)
     {
@@ -262,32 +1561,44 @@ for (i = 0; i < MULTITHREAD; i++)
         results[0].iterations *= 1 + 10 / divisor;
     }
     /* perform actual benchmark */
-    start_time();
 #if (MULTITHREAD > 1)
     if (default_num_contexts > MULTITHREAD)
     {
         default_num_contexts = MULTITHREAD;
     }
-    for (i = 0; i < default_num_contexts; i++)
-    {
-        results[i].iterations = results[0].iterations;
-        results[i].execs      = results[0].execs;
-        core_start_parallel(&results[i]);
-    }
-    for (i = 0; i < default_num_contexts; i++)
+#endif
+#if TRIALS
+    for (trial = 0; trial < TRIALS_WARMUP; trial++)
+        clocked_run(results);
+    for (trial = 0; trial < TRIALS; trial++)
     {
-        core_stop_parallel(&results[i]);
+        trial_ticks[trial] = timed_run(results);
+#if USE_PERF
+        perf_counters_save(trial);
+#endif
     }
+    trial_statistics(trial_ticks,
+                     default_num_contexts * results[0].iterations,
+                     &trials);
+    total_time = trial_ticks[trials.median_trial];
+#if USE_PERF
+    /* the counts reported are those of the trial reported */
+    perf_counters_restore(trials.median_trial);
+#endif
 #else
-    iterate(&results[0]);
+    total_time = timed_run(results);
 #endif
-    stop_time();
-    total_time = get_time();
     /* get a function of the input to report */
     seedcrc = crc16(results[0].seed1, seedcrc);
     seedcrc = crc16(results[0].seed2, seedcrc);
     seedcrc = crc16(results[0].seed3, seedcrc);
     seedcrc = crc16(results[0].size, seedcrc);
+#if MATRIX_N
+    seedcrc = crc16(MATRIX_N, seedcrc);
+#endif
+#if (CALC_CACHE == CALC_CACHE_TABLE)
+    seedcrc = crc16(CALC_CACHE_SIZE, seedcrc);
+#endif
 
     switch (seedcrc)
     {                /* test known output for common seeds */
@@ -321,42 +1632,20 @@ for (i = 0; i < MULTITHREAD; i++)
     if (known_id >= 0)
     {
         for (i = 0; i < default_num_contexts; i++)
-        {
-            results[i].err = 0;
-            if ((results[i].execs & ID_LIST)
-                && (results[i].crclist != list_known_crc[known_id]))
-            {
-                ee_printf("[%u]ERROR! list crc 0x%04x - should be 0x%04x\n",
-                          i,
-                          results[i].crclist,
-                          list_known_crc[known_id]);
-                results[i].err++;
-            }
-            if ((results[i].execs & ID_MATRIX)
-                && (results[i].crcmatrix != matrix_known_crc[known_id]))
-            {
-                ee_printf("[%u]ERROR! matrix crc 0x%04x - should be 0x%04x\n",
-                          i,
-                          results[i].crcmatrix,
-                          matrix_known_crc[known_id]);
-                results[i].err++;
-            }
-            if ((results[i].execs & ID_STATE)
-                && (results[i].crcstate != state_known_crc[known_id]))
-            {
-                ee_printf("[%u]ERROR! state crc 0x%04x - should be 0x%04x\n",
-                          i,
-                          results[i].crcstate,
-                          state_known_crc[known_id]);
-                results[i].err++;
-            }
-            total_errors += results[i].err;
-        }
+            total_errors += check_known_crc(&results[i], i, known_id);
     }
     total_errors += check_data_types();
     /* and report results */
     ee_printf("CoreMark Size    : %lu\n", (long unsigned)results[0].size);
     ee_printf("Total ticks      : %lu\n", (long unsigned)total_time);
+#if KERNEL_TIMING
+    for (i = 0; i < default_num_contexts; i++)
+        report_kernel_times(i, &results[i].ktimes);
+#endif
+#if CALC_STATS
+    for (i = 0; i < default_num_contexts; i++)
+        report_calc_stats(i, &results[i]);
+#endif
 #if HAS_FLOAT
     ee_printf("Total time (secs): %f\n", time_in_secs(total_time));
     if (time_in_secs(total_time) > 0)
@@ -369,6 +1658,22 @@ for (i = 0; i < MULTITHREAD; i++)
         ee_printf("Iterations/Sec   : %d\n",
                   default_num_contexts * results[0].iterations
                       / time_in_secs(total_time));
+#endif
+#if TRIALS
+    report_trials(&trials);
+#endif
+#if MATRIX_SIMD
+    total_errors += check_simd(results);
+#endif
+#if STATE_SIMD
+    if (results[0].execs & ID_STATE)
+        total_errors += check_state_scan(&results[0]);
+#endif
+#if LIST_CHASE
+    total_errors += list_chase(&results[0]);
+#endif
+#if SCALE_SWEEP
+    total_errors += scale_sweep(results);
 #endif
     if (time_in_secs(total_time) < 10)
     {
@@ -385,6 +1690,23 @@ for (i = 0; i < MULTITHREAD; i++)
     ee_printf("Parallel %s : %d\n", PARALLEL_METHOD, default_num_contexts);
 #endif
     ee_printf("Memory location  : %s\n", MEM_LOCATION);
+#if (CRC_METHOD != CRC_BITWISE)
+    ee_printf("CRC engine       : %s\n", crc_name[CRC_METHOD]);
+#endif
+#if (STATE_ENGINE != STATE_SWITCH)
+    ee_printf("State machine    : %s\n", state_name[STATE_ENGINE]);
+#endif
+#if LIST_SOA
+    ee_printf("List layout      : %s\n", list_name[LIST_SOA]);
+#endif
+#if (LIST_SORT != LIST_SORT_MERGE)
+    ee_printf("List sort        : %s\n", list_sort_name[LIST_SORT]);
+#endif
+#if MATRIX_N || (MATMUL_METHOD != MATMUL_NAIVE)
+    ee_printf("Matrix multiply  : %s, N=%d\n",
+              matmul_name[MATMUL_METHOD],
+              results[0].mat.N);
+#endif
     /* output for verification */
     ee_printf("seedcrc          : 0x%04x\n", seedcrc);
     if (results[0].execs & ID_LIST)
@@ -406,7 +1728,14 @@ for (i = 0; i < MULTITHREAD; i++)
 #if HAS_FLOAT
         if (known_id == 3)
         {
+#if CORE_VARIANT
+            /* not a reference score, keep it apart from CoreMark 1.0 */
+            ee_printf("CoreMark 1.0 variant (");
+            print_variant();
+            ee_printf(") : %f / %s %s",
+#else
             ee_printf("CoreMark 1.0 : %f / %s %s",
+#endif
                       default_num_contexts * results[0].iterations
                           / time_in_secs(total_time),
                       COMPILER_VERSION,
@@ -431,6 +1760,10 @@ for (i = 0; i < MULTITHREAD; i++)
             "Cannot validate operation for these seed values, please compare "
             "with results on a known platform.\n");
 
+#if (REPORT_FORMAT != REPORT_TEXT)
+    report_record(results, total_time, seedcrc, known_id, total_errors);
+#endif
+
 #if (MEM_METHOD == MEM_MALLOC)
     for (i = 0; i < MULTITHREAD; i++)
         portable_free(results[i].memblock[0]);
@@ -35,19 +35,292 @@ zero). NxN Matrix C - used for the result.
         The actual values for A and B must be derived based on input that is not
 available at compile time.
 */
-ee_s16 matrix_test(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B, MATDAT val);
-ee_s16 matrix_sum(ee_u32 N, MATRES *C, MATDAT clipval);
-void   matrix_mul_const(ee_u32 N, MATRES *C, MATDAT *A, MATDAT val);
-void   matrix_mul_vect(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B);
-void   matrix_mul_matrix(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B);
-void   matrix_mul_matrix_bitextract(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B);
-void   matrix_add_const(ee_u32 N, MATDAT *A, MATDAT val);
+#if MATRIX_SIMD && defined(__GNUC__) && !defined(__clang__)
+/* the scalar kernels stay the reference: the SIMD extension enabled for the
+ * vector kernels must not be used to auto-vectorize them */
+#define MATRIX_SCALAR __attribute__((optimize("no-tree-vectorize")))
+#else
+#define MATRIX_SCALAR
+#endif
+MATRIX_SCALAR ee_s16
+matrix_test(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B, MATDAT val);
+MATRIX_SCALAR ee_s16 matrix_sum(ee_u32 N, MATRES *C, MATDAT clipval);
+MATRIX_SCALAR void matrix_mul_const(ee_u32 N, MATRES *C, MATDAT *A, MATDAT val);
+MATRIX_SCALAR void matrix_mul_vect(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B);
+MATRIX_SCALAR void matrix_mul_matrix(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B);
+MATRIX_SCALAR void
+matrix_mul_matrix_bitextract(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B);
+MATRIX_SCALAR void matrix_add_const(ee_u32 N, MATDAT *A, MATDAT val);
 
 #define matrix_test_next(x)      (x + 1)
 #define matrix_clip(x, y)        ((y) ? (x)&0x0ff : (x)&0x0ffff)
 #define matrix_big(x)            (0xf000 | (x))
 #define bit_extract(x, from, to) (((x) >> (from)) & (~(0xffffffff << (to))))
 
+/* element (k, j) of the operator matrix, which MATMUL_TRANSPOSED keeps
+ * stored column by column */
+#if (MATMUL_METHOD == MATMUL_TRANSPOSED)
+#define matrix_b(B, N, k, j) B[(j) * (N) + (k)]
+#if MATRIX_SIMD
+#error "MATRIX_SIMD kernels read B by rows, use another MATMUL_METHOD"
+#endif
+#else
+#define matrix_b(B, N, k, j) B[(k) * (N) + (j)]
+#endif
+#define matrix_min(a, b) (((a) < (b)) ? (a) : (b))
+
+#if MATRIX_SIMD
+/* Topic: Vector kernels
+        Hand vectorized versions of the matrix kernels, selected at run time
+   by <matrix_simd>. Lanes hold MATRES values, MATDAT inputs are sign extended
+   on load. Integer sums wrap the same way in any order, so the results are
+   bit identical to the scalar kernels. Columns that do not fill a vector are
+   done by the scalar code.
+
+        Each extension provides:
+        vec_init - declare vl, the number of 32b lanes.
+        vec_load16(p) - vl MATDAT from p, widened to MATRES.
+        vec_set1(x), vec_mul(a,b), vec_add(a,b), vec_and(a,b) - lane wise.
+        vec_sr(a,n) - shift right each lane by the constant n.
+        vec_store(p,a) - vl MATRES to p.
+        vec_hsum(a) - sum of the lanes.
+        vec_add16(p,v) - add v to the 2*vl MATDAT at p.
+*/
+#if !MATDAT_INT
+#error "MATRIX_SIMD needs integer matrix data"
+#elif defined(__AVX512BW__)
+#include <immintrin.h>
+typedef __m512i vec_t;
+#define MATRIX_SIMD_ISA      "AVX-512BW"
+#define vec_init             const ee_u32 vl = 16
+#define vec_load16(p)        _mm512_cvtepi16_epi32(_mm256_loadu_si256((const __m256i *)(p)))
+#define vec_set1(x)          _mm512_set1_epi32(x)
+#define vec_mul(a, b)        _mm512_mullo_epi32(a, b)
+#define vec_add(a, b)        _mm512_add_epi32(a, b)
+#define vec_and(a, b)        _mm512_and_si512(a, b)
+#define vec_sr(a, n)         _mm512_srli_epi32(a, n)
+#define vec_store(p, a)      _mm512_storeu_si512((void *)(p), a)
+#define vec_hsum(a)          _mm512_reduce_add_epi32(a)
+#define vec_add16(p, v)                                                      \
+    _mm512_storeu_si512(                                                     \
+        (void *)(p),                                                         \
+        _mm512_add_epi16(_mm512_loadu_si512((const void *)(p)),             \
+                         _mm512_set1_epi16(v)))
+#elif defined(__AVX2__)
+#include <immintrin.h>
+typedef __m256i vec_t;
+#define MATRIX_SIMD_ISA      "AVX2"
+#define vec_init             const ee_u32 vl = 8
+#define vec_load16(p)        _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(p)))
+#define vec_set1(x)          _mm256_set1_epi32(x)
+#define vec_mul(a, b)        _mm256_mullo_epi32(a, b)
+#define vec_add(a, b)        _mm256_add_epi32(a, b)
+#define vec_and(a, b)        _mm256_and_si256(a, b)
+#define vec_sr(a, n)         _mm256_srli_epi32(a, n)
+#define vec_store(p, a)      _mm256_storeu_si256((__m256i *)(p), a)
+#define vec_hsum(a)                                                          \
+    vec_hsum128(_mm_add_epi32(_mm256_castsi256_si128(a),                     \
+                              _mm256_extracti128_si256(a, 1)))
+#define vec_add16(p, v)                                                      \
+    _mm256_storeu_si256(                                                     \
+        (__m256i *)(p),                                                      \
+        _mm256_add_epi16(_mm256_loadu_si256((const __m256i *)(p)),          \
+                         _mm256_set1_epi16(v)))
+static inline MATRES
+vec_hsum128(__m128i a)
+{
+    a = _mm_add_epi32(a, _mm_shuffle_epi32(a, 0x4e));
+    a = _mm_add_epi32(a, _mm_shuffle_epi32(a, 0xb1));
+    return _mm_cvtsi128_si32(a);
+}
+#elif defined(__SSE4_1__)
+#include <smmintrin.h>
+typedef __m128i vec_t;
+#define MATRIX_SIMD_ISA      "SSE4.1"
+#define vec_init             const ee_u32 vl = 4
+#define vec_load16(p)        _mm_cvtepi16_epi32(_mm_loadl_epi64((const __m128i *)(p)))
+#define vec_set1(x)          _mm_set1_epi32(x)
+#define vec_mul(a, b)        _mm_mullo_epi32(a, b)
+#define vec_add(a, b)        _mm_add_epi32(a, b)
+#define vec_and(a, b)        _mm_and_si128(a, b)
+#define vec_sr(a, n)         _mm_srli_epi32(a, n)
+#define vec_store(p, a)      _mm_storeu_si128((__m128i *)(p), a)
+#define vec_hsum(a)          vec_hsum128(a)
+#define vec_add16(p, v)                                                      \
+    _mm_storeu_si128((__m128i *)(p),                                         \
+                     _mm_add_epi16(_mm_loadu_si128((const __m128i *)(p)),   \
+                                   _mm_set1_epi16(v)))
+static inline MATRES
+vec_hsum128(__m128i a)
+{
+    a = _mm_add_epi32(a, _mm_shuffle_epi32(a, 0x4e));
+    a = _mm_add_epi32(a, _mm_shuffle_epi32(a, 0xb1));
+    return _mm_cvtsi128_si32(a);
+}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+typedef int32x4_t vec_t;
+#define MATRIX_SIMD_ISA      "NEON"
+#define vec_init             const ee_u32 vl = 4
+#define vec_load16(p)        vmovl_s16(vld1_s16(p))
+#define vec_set1(x)          vdupq_n_s32(x)
+#define vec_mul(a, b)        vmulq_s32(a, b)
+#define vec_add(a, b)        vaddq_s32(a, b)
+#define vec_and(a, b)        vandq_s32(a, b)
+#define vec_sr(a, n)         vshrq_n_s32(a, n)
+#define vec_store(p, a)      vst1q_s32(p, a)
+#define vec_hsum(a)          vaddvq_s32(a)
+#define vec_add16(p, v)      vst1q_s16(p, vaddq_s16(vld1q_s16(p), vdupq_n_s16(v)))
+#elif defined(__riscv_vector)
+#include <riscv_vector.h>
+typedef vint32m1_t vec_t;
+#define MATRIX_SIMD_ISA      "RVV"
+#define vec_init             const ee_u32 vl = (ee_u32)__riscv_vsetvlmax_e32m1()
+#define vec_load16(p)        __riscv_vsext_vf2_i32m1(__riscv_vle16_v_i16mf2(p, vl), vl)
+#define vec_set1(x)          __riscv_vmv_v_x_i32m1(x, vl)
+#define vec_mul(a, b)        __riscv_vmul_vv_i32m1(a, b, vl)
+#define vec_add(a, b)        __riscv_vadd_vv_i32m1(a, b, vl)
+#define vec_and(a, b)        __riscv_vand_vv_i32m1(a, b, vl)
+#define vec_sr(a, n)         __riscv_vsra_vx_i32m1(a, n, vl)
+#define vec_store(p, a)      __riscv_vse32_v_i32m1(p, a, vl)
+#define vec_hsum(a)                                                          \
+    __riscv_vmv_x_s_i32m1_i32(__riscv_vredsum_vs_i32m1_i32m1(                \
+        a, __riscv_vmv_s_x_i32m1(0, vl), vl))
+#define vec_add16(p, v)                                                      \
+    __riscv_vse16_v_i16m1(                                                   \
+        p, __riscv_vadd_vx_i16m1(__riscv_vle16_v_i16m1(p, 2 * vl), v, 2 * vl), \
+        2 * vl)
+#else
+#error "MATRIX_SIMD needs AVX-512BW, AVX2, SSE4.1, NEON or RVV enabled"
+#endif
+
+ee_u8       matrix_simd;
+const char *matrix_simd_isa = MATRIX_SIMD_ISA;
+
+static void
+matrix_add_const_vec(ee_u32 N, MATDAT *A, MATDAT val)
+{
+    vec_init;
+    ee_u32 i;
+    for (i = 0; i + 2 * vl <= N * N; i += 2 * vl)
+        vec_add16(A + i, val);
+    for (; i < N * N; i++)
+        A[i] += val;
+}
+
+static void
+matrix_mul_const_vec(ee_u32 N, MATRES *C, MATDAT *A, MATDAT val)
+{
+    vec_init;
+    vec_t  v = vec_set1(val);
+    ee_u32 i;
+    for (i = 0; i + vl <= N * N; i += vl)
+        vec_store(C + i, vec_mul(vec_load16(A + i), v));
+    for (; i < N * N; i++)
+        C[i] = (MATRES)A[i] * (MATRES)val;
+}
+
+static void
+matrix_mul_vect_vec(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B)
+{
+    vec_init;
+    ee_u32 i, j;
+    for (i = 0; i < N; i++)
+    {
+        vec_t  acc = vec_set1(0);
+        MATRES sum;
+        for (j = 0; j + vl <= N; j += vl)
+            acc = vec_add(acc,
+                          vec_mul(vec_load16(A + i * N + j), vec_load16(B + j)));
+        sum = vec_hsum(acc);
+        for (; j < N; j++)
+            sum += (MATRES)A[i * N + j] * (MATRES)B[j];
+        C[i] = sum;
+    }
+}
+
+/* vl columns of C at a time, A[i][k] broadcast against row k of B */
+static void
+matrix_mul_matrix_vec(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B)
+{
+    vec_init;
+    ee_u32 i, j, k;
+    for (i = 0; i < N; i++)
+    {
+        for (j = 0; j + vl <= N; j += vl)
+        {
+            vec_t acc = vec_set1(0);
+            for (k = 0; k < N; k++)
+                acc = vec_add(acc,
+                              vec_mul(vec_set1(A[i * N + k]),
+                                      vec_load16(B + k * N + j)));
+            vec_store(C + i * N + j, acc);
+        }
+        for (; j < N; j++)
+        {
+            C[i * N + j] = 0;
+            for (k = 0; k < N; k++)
+                C[i * N + j] += (MATRES)A[i * N + k] * (MATRES)B[k * N + j];
+        }
+    }
+}
+
+static void
+matrix_mul_matrix_bitextract_vec(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B)
+{
+    vec_init;
+    vec_t  m4 = vec_set1(0xf), m7 = vec_set1(0x7f);
+    ee_u32 i, j, k;
+    for (i = 0; i < N; i++)
+    {
+        for (j = 0; j + vl <= N; j += vl)
+        {
+            vec_t acc = vec_set1(0);
+            for (k = 0; k < N; k++)
+            {
+                vec_t tmp = vec_mul(vec_set1(A[i * N + k]),
+                                    vec_load16(B + k * N + j));
+                acc       = vec_add(acc,
+                              vec_mul(vec_and(vec_sr(tmp, 2), m4),
+                                      vec_and(vec_sr(tmp, 5), m7)));
+            }
+            vec_store(C + i * N + j, acc);
+        }
+        for (; j < N; j++)
+        {
+            C[i * N + j] = 0;
+            for (k = 0; k < N; k++)
+            {
+                MATRES tmp = (MATRES)A[i * N + k] * (MATRES)B[k * N + j];
+                C[i * N + j] += bit_extract(tmp, 2, 4) * bit_extract(tmp, 5, 7);
+            }
+        }
+    }
+}
+
+/* Function: matrix_test_vec
+        <matrix_test> with the vector kernels.
+*/
+static ee_s16
+matrix_test_vec(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B, MATDAT val)
+{
+    ee_u16 crc     = 0;
+    MATDAT clipval = matrix_big(val);
+
+    matrix_add_const_vec(N, A, val);
+    matrix_mul_const_vec(N, C, A, val);
+    crc = crc16(matrix_sum(N, C, clipval), crc);
+    matrix_mul_vect_vec(N, C, A, B);
+    crc = crc16(matrix_sum(N, C, clipval), crc);
+    matrix_mul_matrix_vec(N, C, A, B);
+    crc = crc16(matrix_sum(N, C, clipval), crc);
+    matrix_mul_matrix_bitextract_vec(N, C, A, B);
+    crc = crc16(matrix_sum(N, C, clipval), crc);
+    matrix_add_const_vec(N, A, -val);
+    return crc;
+}
+#endif
+
 #if CORE_DEBUG
 void
 printmat(MATDAT *A, ee_u32 N, char *name)
@@ -132,6 +405,11 @@ matrix_test(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B, MATDAT val)
     ee_u16 crc     = 0;
     MATDAT clipval = matrix_big(val);
 
+#if MATRIX_SIMD
+    if (matrix_simd)
+        return matrix_test_vec(N, C, A, B, val);
+#endif
+
     matrix_add_const(N, A, val); /* make sure data changes  */
 #if CORE_DEBUG
     printmat(A, N, "matrix_add_const");
@@ -204,7 +482,7 @@ core_init_matrix(ee_u32 blksize, void *memblk, ee_s32 seed, mat_params *p)
             seed         = ((order * seed) % 65536);
             val          = (seed + order);
             val          = matrix_clip(val, 0);
-            B[i * N + j] = val;
+            matrix_b(B, N, i, j) = val;
             val          = (val + order);
             val          = matrix_clip(val, 1);
             A[i * N + j] = val;
@@ -308,7 +586,7 @@ matrix_mul_vect(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B)
         C[i] = 0;
         for (j = 0; j < N; j++)
         {
-            C[i] += (MATRES)A[i * N + j] * (MATRES)B[j];
+            C[i] += (MATRES)A[i * N + j] * (MATRES)matrix_b(B, N, 0, j);
         }
     }
 }
@@ -317,7 +595,41 @@ matrix_mul_vect(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B)
         Multiply a matrix by a matrix.
         Basic code is used in many algorithms, mostly with minor changes such as
    scaling.
+
+        With MATMUL_BLOCKED the product is accumulated over MATMUL_TILE square
+   tiles of A, B and C, and with MATMUL_TRANSPOSED B is read along its stored
+   columns. Integer sums wrap the same in any order, so all methods give the
+   same C.
 */
+#if (MATMUL_METHOD == MATMUL_BLOCKED)
+void
+matrix_mul_matrix(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B)
+{
+    ee_u32 i, j, k, ii, jj, kk;
+    for (i = 0; i < N * N; i++)
+        C[i] = 0;
+    for (ii = 0; ii < N; ii += MATMUL_TILE)
+    {
+        for (kk = 0; kk < N; kk += MATMUL_TILE)
+        {
+            for (jj = 0; jj < N; jj += MATMUL_TILE)
+            {
+                for (i = ii; i < matrix_min(ii + MATMUL_TILE, N); i++)
+                {
+                    for (k = kk; k < matrix_min(kk + MATMUL_TILE, N); k++)
+                    {
+                        MATRES a = A[i * N + k];
+                        for (j = jj; j < matrix_min(jj + MATMUL_TILE, N); j++)
+                        {
+                            C[i * N + j] += a * (MATRES)B[k * N + j];
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+#else
 void
 matrix_mul_matrix(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B)
 {
@@ -329,17 +641,50 @@ matrix_mul_matrix(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B)
             C[i * N + j] = 0;
             for (k = 0; k < N; k++)
             {
-                C[i * N + j] += (MATRES)A[i * N + k] * (MATRES)B[k * N + j];
+                C[i * N + j]
+                    += (MATRES)A[i * N + k] * (MATRES)matrix_b(B, N, k, j);
             }
         }
     }
 }
+#endif
 
 /* Function: matrix_mul_matrix_bitextract
         Multiply a matrix by a matrix, and extract some bits from the result.
         Basic code is used in many algorithms, mostly with minor changes such as
    scaling.
 */
+#if (MATMUL_METHOD == MATMUL_BLOCKED)
+void
+matrix_mul_matrix_bitextract(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B)
+{
+    ee_u32 i, j, k, ii, jj, kk;
+    for (i = 0; i < N * N; i++)
+        C[i] = 0;
+    for (ii = 0; ii < N; ii += MATMUL_TILE)
+    {
+        for (kk = 0; kk < N; kk += MATMUL_TILE)
+        {
+            for (jj = 0; jj < N; jj += MATMUL_TILE)
+            {
+                for (i = ii; i < matrix_min(ii + MATMUL_TILE, N); i++)
+                {
+                    for (k = kk; k < matrix_min(kk + MATMUL_TILE, N); k++)
+                    {
+                        MATRES a = A[i * N + k];
+                        for (j = jj; j < matrix_min(jj + MATMUL_TILE, N); j++)
+                        {
+                            MATRES tmp = a * (MATRES)B[k * N + j];
+                            C[i * N + j] += bit_extract(tmp, 2, 4)
+                                            * bit_extract(tmp, 5, 7);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+#else
 void
 matrix_mul_matrix_bitextract(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B)
 {
@@ -351,9 +696,10 @@ matrix_mul_matrix_bitextract(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B)
             C[i * N + j] = 0;
             for (k = 0; k < N; k++)
             {
-                MATRES tmp = (MATRES)A[i * N + k] * (MATRES)B[k * N + j];
+                MATRES tmp = (MATRES)A[i * N + k] * (MATRES)matrix_b(B, N, k, j);
                 C[i * N + j] += bit_extract(tmp, 2, 4) * bit_extract(tmp, 5, 7);
             }
         }
     }
 }
+#endif
@@ -19,6 +19,12 @@ Original Author: Shay Gal-on
 #include "coremark.h"
 /* local functions */
 enum CORE_STATE core_state_transition(ee_u8 **instr, ee_u32 *transition_count);
+#if STATE_SIMD
+static ee_u32 state_scan(ee_u8  *memblock,
+                         ee_u32 blksize,
+                         ee_u32 *final_counts,
+                         ee_u32 *transition_count);
+#endif
 
 /*
 Topic: Description
@@ -51,7 +57,12 @@ core_bench_state(ee_u32 blksize,
                  ee_u16 crc)
 {
     ee_u32 final_counts[NUM_CORE_STATES];
+#if (STATE_ENGINE == STATE_TABLE)
+    /* one more slot, taking the counts of transitions that count nothing */
+    ee_u32 track_counts[NUM_CORE_STATES + 1];
+#else
     ee_u32 track_counts[NUM_CORE_STATES];
+#endif
     ee_u8 *p = memblock;
     ee_u32 i;
 
@@ -62,6 +73,9 @@ core_bench_state(ee_u32 blksize,
     {
         final_counts[i] = track_counts[i] = 0;
     }
+#if (STATE_ENGINE == STATE_TABLE)
+    track_counts[NUM_CORE_STATES] = 0;
+#endif
     /* run the state machine over the input */
     while (*p != 0)
     {
@@ -126,6 +140,415 @@ static ee_u8 *errpat[4]   = { (ee_u8 *)"T0.3e-1F",
                             (ee_u8 *)"1T3.4e4z",
                             (ee_u8 *)"34.0e-T^" };
 
+#if (STATE_ENGINE == STATE_TABLE) || STATE_SIMD
+/* Topic: Transition table
+        The machine of <core_state_transition> as tables indexed by state and
+   input byte class. Each entry of <state_count> names the transition counts
+   to bump, in the low and high nibble, NUM_CORE_STATES being a discarded
+   slot. A ',' ends the token before the lookup.
+*/
+#define STATE_DIGIT       0
+#define STATE_SIGN        1
+#define STATE_DOT         2
+#define STATE_EXP         3
+#define STATE_OTHER       4
+#define STATE_COMMA       5
+#define STATE_END         6 /* the 0 ending the input, <state_scan> only */
+#define NUM_STATE_CLASSES 5
+
+static ee_u8 state_class[256];
+
+static const ee_u8 state_next[NUM_CORE_STATES][NUM_STATE_CLASSES] = {
+    /*                digit            sign            dot
+                      e/E              other */
+    /* START */ { CORE_INT,        CORE_S1,        CORE_FLOAT,
+                  CORE_INVALID,    CORE_INVALID },
+    /* INVALID */ { CORE_INVALID,  CORE_INVALID,   CORE_INVALID,
+                    CORE_INVALID,  CORE_INVALID },
+    /* S1 */ { CORE_INT,           CORE_INVALID,   CORE_FLOAT,
+               CORE_INVALID,       CORE_INVALID },
+    /* S2 */ { CORE_INVALID,       CORE_EXPONENT,  CORE_INVALID,
+               CORE_INVALID,       CORE_INVALID },
+    /* INT */ { CORE_INT,          CORE_INVALID,   CORE_FLOAT,
+                CORE_INVALID,      CORE_INVALID },
+    /* FLOAT */ { CORE_FLOAT,      CORE_INVALID,   CORE_INVALID,
+                  CORE_S2,         CORE_INVALID },
+    /* EXPONENT */ { CORE_SCIENTIFIC, CORE_INVALID, CORE_INVALID,
+                     CORE_INVALID,    CORE_INVALID },
+    /* SCIENTIFIC */ { CORE_SCIENTIFIC, CORE_INVALID, CORE_INVALID,
+                       CORE_INVALID,    CORE_INVALID },
+};
+
+#define COUNT1(a)    ((a) | (NUM_CORE_STATES << 4))
+#define COUNT2(a, b) ((a) | ((b) << 4))
+#define COUNT0       COUNT1(NUM_CORE_STATES)
+
+static const ee_u8 state_count[NUM_CORE_STATES][NUM_STATE_CLASSES] = {
+    /* START */
+    { COUNT1(CORE_START), COUNT1(CORE_START), COUNT1(CORE_START),
+      COUNT2(CORE_START, CORE_INVALID), COUNT2(CORE_START, CORE_INVALID) },
+    /* INVALID */
+    { COUNT0, COUNT0, COUNT0, COUNT0, COUNT0 },
+    /* S1 */
+    { COUNT1(CORE_S1), COUNT1(CORE_S1), COUNT1(CORE_S1), COUNT1(CORE_S1),
+      COUNT1(CORE_S1) },
+    /* S2 */
+    { COUNT1(CORE_S2), COUNT1(CORE_S2), COUNT1(CORE_S2), COUNT1(CORE_S2),
+      COUNT1(CORE_S2) },
+    /* INT */
+    { COUNT0, COUNT1(CORE_INT), COUNT1(CORE_INT), COUNT1(CORE_INT),
+      COUNT1(CORE_INT) },
+    /* FLOAT */
+    { COUNT0, COUNT1(CORE_FLOAT), COUNT1(CORE_FLOAT), COUNT1(CORE_FLOAT),
+      COUNT1(CORE_FLOAT) },
+    /* EXPONENT */
+    { COUNT1(CORE_EXPONENT), COUNT1(CORE_EXPONENT), COUNT1(CORE_EXPONENT),
+      COUNT1(CORE_EXPONENT), COUNT1(CORE_EXPONENT) },
+    /* SCIENTIFIC */
+    { COUNT0, COUNT1(CORE_INVALID), COUNT1(CORE_INVALID),
+      COUNT1(CORE_INVALID), COUNT1(CORE_INVALID) },
+};
+
+static void
+state_init_classes(void)
+{
+    ee_u32 c;
+    for (c = 0; c < 256; c++)
+        state_class[c] = STATE_OTHER;
+    for (c = '0'; c <= '9'; c++)
+        state_class[c] = STATE_DIGIT;
+    state_class['+'] = STATE_SIGN;
+    state_class['-'] = STATE_SIGN;
+    state_class['.'] = STATE_DOT;
+    state_class['e'] = STATE_EXP;
+    state_class['E'] = STATE_EXP;
+    state_class[','] = STATE_COMMA;
+}
+#endif
+
+#if STATE_SIMD
+/* Topic: Vector scan
+        <state_scan> loads STATE_SIMD_WIDTH input bytes at a time and sorts
+   them into the classes of the <Transition table> with vector compares. The
+   ',' and 0 bytes ending the tokens come out as a bit mask, so the machine
+   is then replayed from the classes one token at a time, without looking at
+   the input again and without end of token checks.
+
+        Each extension provides:
+        state_classify(p, cls, digits) - classes of the STATE_SIMD_WIDTH bytes
+   at p to cls and the mask of the digits to digits, returns the mask of the
+   ',' and 0 bytes.
+        state_stop(m) - index of the first byte in the mask m.
+        state_run(m, i) - number of bytes in the mask m from byte i on.
+*/
+typedef unsigned long long state_mask;
+
+#if defined(__AVX512BW__)
+#include <immintrin.h>
+#define STATE_SIMD_ISA   "AVX-512BW"
+#define STATE_SIMD_WIDTH 64
+#define state_stop(m)    ((ee_u32)__builtin_ctzll(m))
+#define state_run(m, i)  ((ee_u32)__builtin_ctzll(~((m) >> (i))))
+
+static state_mask
+state_classify(const ee_u8 *p, ee_u8 *cls, state_mask *digits)
+{
+    __m512i   c     = _mm512_loadu_si512((const void *)p);
+    __m512i   k     = _mm512_set1_epi8(STATE_OTHER);
+    __mmask64 digit = _mm512_cmplt_epu8_mask(
+        _mm512_sub_epi8(c, _mm512_set1_epi8('0')), _mm512_set1_epi8(10));
+    __mmask64 comma, end;
+
+    k = _mm512_mask_mov_epi8(k, digit, _mm512_set1_epi8(STATE_DIGIT));
+    k = _mm512_mask_mov_epi8(
+        k,
+        _mm512_cmpeq_epi8_mask(c, _mm512_set1_epi8('+'))
+            | _mm512_cmpeq_epi8_mask(c, _mm512_set1_epi8('-')),
+        _mm512_set1_epi8(STATE_SIGN));
+    k = _mm512_mask_mov_epi8(k,
+                             _mm512_cmpeq_epi8_mask(c, _mm512_set1_epi8('.')),
+                             _mm512_set1_epi8(STATE_DOT));
+    k = _mm512_mask_mov_epi8(
+        k,
+        _mm512_cmpeq_epi8_mask(_mm512_or_si512(c, _mm512_set1_epi8(0x20)),
+                               _mm512_set1_epi8('e')),
+        _mm512_set1_epi8(STATE_EXP));
+    comma = _mm512_cmpeq_epi8_mask(c, _mm512_set1_epi8(','));
+    end   = _mm512_cmpeq_epi8_mask(c, _mm512_setzero_si512());
+    k     = _mm512_mask_mov_epi8(k, comma, _mm512_set1_epi8(STATE_COMMA));
+    k     = _mm512_mask_mov_epi8(k, end, _mm512_set1_epi8(STATE_END));
+    _mm512_storeu_si512((void *)cls, k);
+    *digits = digit;
+    return comma | end;
+}
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define STATE_SIMD_ISA   "AVX2"
+#define STATE_SIMD_WIDTH 32
+#define state_stop(m)    ((ee_u32)__builtin_ctzll(m))
+#define state_run(m, i)  ((ee_u32)__builtin_ctzll(~((m) >> (i))))
+
+static state_mask
+state_classify(const ee_u8 *p, ee_u8 *cls, state_mask *digits)
+{
+    __m256i c = _mm256_loadu_si256((const __m256i *)p);
+    __m256i d = _mm256_sub_epi8(c, _mm256_set1_epi8('0'));
+    __m256i digit
+        = _mm256_cmpeq_epi8(_mm256_min_epu8(d, _mm256_set1_epi8(9)), d);
+    __m256i sign = _mm256_or_si256(
+        _mm256_cmpeq_epi8(c, _mm256_set1_epi8('+')),
+        _mm256_cmpeq_epi8(c, _mm256_set1_epi8('-')));
+    __m256i dot = _mm256_cmpeq_epi8(c, _mm256_set1_epi8('.'));
+    __m256i exp = _mm256_cmpeq_epi8(
+        _mm256_or_si256(c, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('e'));
+    __m256i comma = _mm256_cmpeq_epi8(c, _mm256_set1_epi8(','));
+    __m256i end   = _mm256_cmpeq_epi8(c, _mm256_setzero_si256());
+    __m256i stop  = _mm256_or_si256(comma, end);
+    __m256i any   = _mm256_or_si256(_mm256_or_si256(digit, sign),
+                                  _mm256_or_si256(_mm256_or_si256(dot, exp),
+                                                  stop));
+    __m256i k     = _mm256_andnot_si256(any, _mm256_set1_epi8(STATE_OTHER));
+
+    k = _mm256_or_si256(k, _mm256_and_si256(sign, _mm256_set1_epi8(STATE_SIGN)));
+    k = _mm256_or_si256(k, _mm256_and_si256(dot, _mm256_set1_epi8(STATE_DOT)));
+    k = _mm256_or_si256(k, _mm256_and_si256(exp, _mm256_set1_epi8(STATE_EXP)));
+    k = _mm256_or_si256(k,
+                        _mm256_and_si256(comma, _mm256_set1_epi8(STATE_COMMA)));
+    k = _mm256_or_si256(k, _mm256_and_si256(end, _mm256_set1_epi8(STATE_END)));
+    _mm256_storeu_si256((__m256i *)cls, k);
+    *digits = (ee_u32)_mm256_movemask_epi8(digit);
+    return (ee_u32)_mm256_movemask_epi8(stop);
+}
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define STATE_SIMD_ISA   "SSE2"
+#define STATE_SIMD_WIDTH 16
+#define state_stop(m)    ((ee_u32)__builtin_ctzll(m))
+#define state_run(m, i)  ((ee_u32)__builtin_ctzll(~((m) >> (i))))
+
+static state_mask
+state_classify(const ee_u8 *p, ee_u8 *cls, state_mask *digits)
+{
+    __m128i c     = _mm_loadu_si128((const __m128i *)p);
+    __m128i d     = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+    __m128i digit = _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(9)), d);
+    __m128i sign  = _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('+')),
+                                _mm_cmpeq_epi8(c, _mm_set1_epi8('-')));
+    __m128i dot   = _mm_cmpeq_epi8(c, _mm_set1_epi8('.'));
+    __m128i exp   = _mm_cmpeq_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)),
+                                 _mm_set1_epi8('e'));
+    __m128i comma = _mm_cmpeq_epi8(c, _mm_set1_epi8(','));
+    __m128i end   = _mm_cmpeq_epi8(c, _mm_setzero_si128());
+    __m128i stop  = _mm_or_si128(comma, end);
+    __m128i any   = _mm_or_si128(_mm_or_si128(digit, sign),
+                               _mm_or_si128(_mm_or_si128(dot, exp), stop));
+    __m128i k     = _mm_andnot_si128(any, _mm_set1_epi8(STATE_OTHER));
+
+    k = _mm_or_si128(k, _mm_and_si128(sign, _mm_set1_epi8(STATE_SIGN)));
+    k = _mm_or_si128(k, _mm_and_si128(dot, _mm_set1_epi8(STATE_DOT)));
+    k = _mm_or_si128(k, _mm_and_si128(exp, _mm_set1_epi8(STATE_EXP)));
+    k = _mm_or_si128(k, _mm_and_si128(comma, _mm_set1_epi8(STATE_COMMA)));
+    k = _mm_or_si128(k, _mm_and_si128(end, _mm_set1_epi8(STATE_END)));
+    _mm_storeu_si128((__m128i *)cls, k);
+    *digits = (ee_u32)_mm_movemask_epi8(digit);
+    return (ee_u32)_mm_movemask_epi8(stop);
+}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define STATE_SIMD_ISA   "NEON"
+#define STATE_SIMD_WIDTH 16
+/* a nibble per byte, the stop mask keeps only its top bit */
+#define state_stop(m)   ((ee_u32)__builtin_ctzll(m) >> 2)
+#define state_run(m, i) ((ee_u32)__builtin_ctzll(~((m) >> (4 * (i)))) >> 2)
+
+static state_mask
+state_classify(const ee_u8 *p, ee_u8 *cls, state_mask *digits)
+{
+    uint8x16_t c     = vld1q_u8(p);
+    uint8x16_t digit = vcltq_u8(vsubq_u8(c, vdupq_n_u8('0')), vdupq_n_u8(10));
+    uint8x16_t sign
+        = vorrq_u8(vceqq_u8(c, vdupq_n_u8('+')), vceqq_u8(c, vdupq_n_u8('-')));
+    uint8x16_t dot = vceqq_u8(c, vdupq_n_u8('.'));
+    uint8x16_t exp
+        = vceqq_u8(vorrq_u8(c, vdupq_n_u8(0x20)), vdupq_n_u8('e'));
+    uint8x16_t comma = vceqq_u8(c, vdupq_n_u8(','));
+    uint8x16_t end   = vceqzq_u8(c);
+    uint8x16_t stop  = vorrq_u8(comma, end);
+    uint8x16_t k     = vdupq_n_u8(STATE_OTHER);
+
+    k = vbslq_u8(digit, vdupq_n_u8(STATE_DIGIT), k);
+    k = vbslq_u8(sign, vdupq_n_u8(STATE_SIGN), k);
+    k = vbslq_u8(dot, vdupq_n_u8(STATE_DOT), k);
+    k = vbslq_u8(exp, vdupq_n_u8(STATE_EXP), k);
+    k = vbslq_u8(comma, vdupq_n_u8(STATE_COMMA), k);
+    k = vbslq_u8(end, vdupq_n_u8(STATE_END), k);
+    vst1q_u8(cls, k);
+    *digits = vget_lane_u64(
+        vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(digit), 4)), 0);
+    return vget_lane_u64(
+               vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(stop), 4)),
+               0)
+           & 0x8888888888888888ull;
+}
+#else
+#error "STATE_SIMD needs AVX-512BW, AVX2, SSE2 or NEON enabled"
+#endif
+
+const char *state_simd_isa = STATE_SIMD_ISA;
+
+/* Function: state_replay
+        Run the table machine from state over the classes cls[from..to),
+   which hold no end of token, counting each transition taken in pairs.
+
+        An invalid byte ends a token by itself, the next one starting right
+   after it, as in <core_state_transition>: <state_resume> goes straight back
+   to CORE_START, and the invalid tokens are found from pairs at the end. A
+   run of digits in a state that loops on them is skipped whole, as it
+   counts nothing.
+*/
+#define STATE_DIGIT_LOOPS \
+    ((1 << CORE_INT) | (1 << CORE_FLOAT) | (1 << CORE_SCIENTIFIC))
+
+static const ee_u8 state_resume[NUM_CORE_STATES][NUM_STATE_CLASSES] = {
+    /* START */ { CORE_INT, CORE_S1, CORE_FLOAT, CORE_START, CORE_START },
+    /* INVALID */ { CORE_START, CORE_START, CORE_START, CORE_START, CORE_START },
+    /* S1 */ { CORE_INT, CORE_START, CORE_FLOAT, CORE_START, CORE_START },
+    /* S2 */ { CORE_START, CORE_EXPONENT, CORE_START, CORE_START, CORE_START },
+    /* INT */ { CORE_INT, CORE_START, CORE_FLOAT, CORE_START, CORE_START },
+    /* FLOAT */ { CORE_FLOAT, CORE_START, CORE_START, CORE_S2, CORE_START },
+    /* EXPONENT */
+    { CORE_SCIENTIFIC, CORE_START, CORE_START, CORE_START, CORE_START },
+    /* SCIENTIFIC */
+    { CORE_SCIENTIFIC, CORE_START, CORE_START, CORE_START, CORE_START },
+};
+
+static ee_u8
+state_replay(ee_u8        state,
+             const ee_u8 *cls,
+             state_mask   digits,
+             ee_u32       from,
+             ee_u32       to,
+             ee_u32 (*pairs)[NUM_STATE_CLASSES])
+{
+    ee_u8 c;
+    while (from < to)
+    {
+        c = cls[from];
+        if (c == STATE_DIGIT && ((STATE_DIGIT_LOOPS >> state) & 1))
+        {
+            from += state_run(digits, from);
+            continue;
+        }
+        pairs[state][c]++;
+        state = state_resume[state][c];
+        from++;
+    }
+    return state;
+}
+
+/* Function: state_scan
+        Count the end states and transitions of the input up to its 0, the
+   same way as the <core_state_transition> loop of <core_bench_state>, and
+   return the number of bytes scanned. The last vector is copied and padded
+   with 0 when it would read past the block. The transitions are counted by
+   state and class first, and only turned into transition counts at the end,
+   so that the common increments do not queue on one counter.
+*/
+static ee_u32
+state_scan(ee_u8  *memblock,
+           ee_u32  blksize,
+           ee_u32 *final_counts,
+           ee_u32 *transition_count)
+{
+    ee_u32     pairs[NUM_CORE_STATES][NUM_STATE_CLASSES];
+    ee_u8      cls[STATE_SIMD_WIDTH], tail[STATE_SIMD_WIDTH];
+    ee_u8      state = CORE_START, count;
+    ee_u32     pos, from, to, i, j;
+    state_mask stops, digits;
+
+    for (i = 0; i < NUM_CORE_STATES; i++)
+        for (j = 0; j < NUM_STATE_CLASSES; j++)
+            pairs[i][j] = 0;
+    for (pos = 0;; pos += STATE_SIMD_WIDTH)
+    {
+        if (pos + STATE_SIMD_WIDTH <= blksize)
+            stops = state_classify(memblock + pos, cls, &digits);
+        else
+        {
+            for (i = 0; i < STATE_SIMD_WIDTH; i++)
+                tail[i] = (pos + i < blksize) ? memblock[pos + i] : 0;
+            stops = state_classify(tail, cls, &digits);
+        }
+        for (from = 0; stops; stops &= stops - 1)
+        {
+            to    = state_stop(stops);
+            state = state_replay(state, cls, digits, from, to, pairs);
+            if (cls[to] == STATE_END)
+                break;
+            final_counts[state]++;
+            state = CORE_START;
+            from  = to + 1;
+        }
+        if (stops)
+            break;
+        state = state_replay(state, cls, digits, from, STATE_SIMD_WIDTH, pairs);
+    }
+    if (state != CORE_START) /* a token cut by the 0 still ends there */
+        final_counts[state]++;
+    for (i = 0; i < NUM_CORE_STATES; i++)
+        for (j = 0; j < NUM_STATE_CLASSES; j++)
+        {
+            count = state_count[i][j];
+            transition_count[count & 0xf] += pairs[i][j];
+            transition_count[count >> 4] += pairs[i][j];
+            if (state_next[i][j] == CORE_INVALID)
+                final_counts[CORE_INVALID] += pairs[i][j];
+        }
+    return pos + to;
+}
+
+/* Function: core_scan_state
+        Run the scan of <core_bench_state> alone, passes times over the
+   input, with <state_scan> if vector is set or <core_state_transition>
+   otherwise, for the parsing rate. Both must return the same crc of the
+   counts of a pass. The bytes scanned by one pass are returned in bytes.
+*/
+ee_u16
+core_scan_state(ee_u32  blksize,
+                ee_u8  *memblock,
+                ee_u32  passes,
+                ee_u8   vector,
+                ee_u32 *bytes)
+{
+    ee_u32 final_counts[NUM_CORE_STATES];
+    ee_u32 track_counts[NUM_CORE_STATES + 1];
+    ee_u8 *p = memblock;
+    ee_u16 crc = 0;
+    ee_u32 i;
+
+    while (passes--)
+    {
+        for (i = 0; i < NUM_CORE_STATES; i++)
+            final_counts[i] = track_counts[i] = 0;
+        track_counts[NUM_CORE_STATES] = 0;
+        if (vector)
+            *bytes = state_scan(memblock, blksize, final_counts, track_counts);
+        else
+        {
+            for (p = memblock; *p != 0;)
+                final_counts[core_state_transition(&p, track_counts)]++;
+            *bytes = (ee_u32)(p - memblock);
+        }
+    }
+    for (i = 0; i < NUM_CORE_STATES; i++)
+    {
+        crc = crcu32(final_counts[i], crc);
+        crc = crcu32(track_counts[i], crc);
+    }
+    return crc;
+}
+#endif
+
 /* Function: core_init_state
         Initialize the input data for the state machine.
 
@@ -144,6 +567,9 @@ core_init_state(ee_u32 size, ee_s16 seed, ee_u8 *p)
 #if CORE_DEBUG
     ee_u8 *start = p;
     ee_printf("State: %d,%d\n", size, seed);
+#endif
+#if (STATE_ENGINE == STATE_TABLE) || STATE_SIMD
+    state_init_classes();
 #endif
     size--;
     next = 0;
@@ -194,14 +620,6 @@ core_init_state(ee_u32 size, ee_s16 seed, ee_u8 *p)
 #endif
 }
 
-static ee_u8
-ee_isdigit(ee_u8 c)
-{
-    ee_u8 retval;
-    retval = ((c >= '0') & (c <= '9')) ? 1 : 0;
-    return retval;
-}
-
 /* Function: core_state_transition
         Actual state machine.
 
@@ -211,7 +629,42 @@ ee_isdigit(ee_u8 c)
 
         The input pointer is updated to point to the end of the token, and the
    end state is returned (either specific format determined or invalid).
+
+        STATE_TABLE looks each step up in the <Transition table> instead of
+   branching on the input.
 */
+#if (STATE_ENGINE == STATE_TABLE)
+enum CORE_STATE
+core_state_transition(ee_u8 **instr, ee_u32 *transition_count)
+{
+    ee_u8 *str   = *instr;
+    ee_u8  state = CORE_START;
+    ee_u8  symbol_class, count;
+    for (; *str && state != CORE_INVALID; str++)
+    {
+        symbol_class = state_class[*str];
+        if (symbol_class == STATE_COMMA) /* end of this input */
+        {
+            str++;
+            break;
+        }
+        count = state_count[state][symbol_class];
+        transition_count[count & 0xf]++;
+        transition_count[count >> 4]++;
+        state = state_next[state][symbol_class];
+    }
+    *instr = str;
+    return (enum CORE_STATE)state;
+}
+#else
+static ee_u8
+ee_isdigit(ee_u8 c)
+{
+    ee_u8 retval;
+    retval = ((c >= '0') & (c <= '9')) ? 1 : 0;
+    return retval;
+}
+
 
 enum CORE_STATE
 core_state_transition(ee_u8 **instr, ee_u32 *transition_count)
@@ -328,3 +781,4 @@ core_state_transition(ee_u8 **instr, ee_u32 *transition_count)
     *instr = str;
     return state;
 }
+#endif
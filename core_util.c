@@ -160,7 +160,11 @@ get_seed_32(int i)
 /* Function: crc*
         Service functions to calculate 16b CRC code.
 
+        The CRC is the reflected form of polynomial 0x8005, i.e. 0xa001 after
+   the shift (the bit serial loop xors 0x4002 before shifting). <CRC_METHOD>
+   selects how it is computed.
 */
+#if (CRC_METHOD == CRC_BITWISE)
 ee_u16
 crcu8(ee_u8 data, ee_u16 crc)
 {
@@ -200,12 +204,173 @@ crcu32(ee_u32 newval, ee_u16 crc)
     crc = crc16((ee_s16)(newval >> 16), crc);
     return crc;
 }
+#else
+#if (CRC_METHOD == CRC_CLMUL)
+#if defined(__x86_64__) && defined(__PCLMUL__)
+#include <wmmintrin.h>
+static inline unsigned long long
+clmul(unsigned long long a, unsigned long long b)
+{
+    return _mm_cvtsi128_si64(_mm_clmulepi64_si128(
+        _mm_cvtsi64_si128(a), _mm_cvtsi64_si128(b), 0));
+}
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_AES)
+#include <arm_neon.h>
+static inline unsigned long long
+clmul(unsigned long long a, unsigned long long b)
+{
+    return vgetq_lane_u64(vreinterpretq_u64_p128(vmull_p64(a, b)), 0);
+}
+#else
+#error "CRC_CLMUL needs -mpclmul on x86_64 or +crypto on AArch64"
+#endif
+
+/* Reflected Barrett reduction of the k message bits in v (crc already
+ * folded in), all products fit in 64b:
+ *  q   = (v * mu') mod x^k,  mu' = reflect(x^(16+k) / P)
+ *  crc = (q * P') / x^k,     P'  = reflect(P)
+ */
+#define CRC_P 0x14003
+static inline ee_u16
+crc_barrett(ee_u32 v, unsigned long long mu, int k)
+{
+    unsigned long long q = clmul(v, mu) & ((1ull << k) - 1);
+    return (ee_u16)(clmul(q, CRC_P) >> k);
+}
+void
+crc_init(void)
+{
+}
+ee_u16
+crcu8(ee_u8 data, ee_u16 crc)
+{
+    return (crc >> 8) ^ crc_barrett((ee_u8)(data ^ crc), 0x1ff, 8);
+}
+ee_u16
+crcu16(ee_u16 newval, ee_u16 crc)
+{
+    return crc_barrett((ee_u16)(newval ^ crc), 0x1bfff, 16);
+}
+ee_u16
+crcu32(ee_u32 newval, ee_u16 crc)
+{
+    return crc_barrett(newval ^ crc, 0x1cfffbfffull, 32);
+}
+#else
+/* crc_table[0] is the byte table, crc_table[n] advances it n more bytes */
+static ee_u16 crc_table[4][256];
+
+/* Function: crc_init
+        Build the lookup tables from the bit serial definition.
+*/
+void
+crc_init(void)
+{
+    ee_u16 i, j, crc;
+
+    for (i = 0; i < 256; i++)
+    {
+        crc = i;
+        for (j = 0; j < 8; j++)
+            crc = (crc & 1) ? (crc >> 1) ^ 0xa001 : (crc >> 1);
+        crc_table[0][i] = crc;
+    }
+    for (j = 1; j < 4; j++)
+        for (i = 0; i < 256; i++)
+            crc_table[j][i] = (crc_table[j - 1][i] >> 8)
+                              ^ crc_table[0][crc_table[j - 1][i] & 0xff];
+}
+ee_u16
+crcu8(ee_u8 data, ee_u16 crc)
+{
+    return (crc >> 8) ^ crc_table[0][(crc ^ data) & 0xff];
+}
+#if (CRC_METHOD == CRC_TABLE)
+ee_u16
+crcu16(ee_u16 newval, ee_u16 crc)
+{
+    crc = crcu8((ee_u8)(newval), crc);
+    crc = crcu8((ee_u8)((newval) >> 8), crc);
+    return crc;
+}
+ee_u16
+crcu32(ee_u32 newval, ee_u16 crc)
+{
+    crc = crc16((ee_s16)newval, crc);
+    crc = crc16((ee_s16)(newval >> 16), crc);
+    return crc;
+}
+#elif (CRC_METHOD == CRC_SLICING)
+ee_u16
+crcu16(ee_u16 newval, ee_u16 crc)
+{
+    crc ^= newval;
+    return crc_table[1][crc & 0xff] ^ crc_table[0][crc >> 8];
+}
+ee_u16
+crcu32(ee_u32 newval, ee_u16 crc)
+{
+    newval ^= crc;
+    return crc_table[3][newval & 0xff] ^ crc_table[2][(newval >> 8) & 0xff]
+           ^ crc_table[1][(newval >> 16) & 0xff] ^ crc_table[0][newval >> 24];
+}
+#else
+#error "Unknown CRC_METHOD"
+#endif
+#endif
+#endif
 ee_u16
 crc16(ee_s16 newval, ee_u16 crc)
 {
     return crcu16((ee_u16)newval, crc);
 }
 
+#if KERNEL_TIMING
+/* Function: kernel_times_reset
+        Clear the per kernel counters, and start accounting to
+   <KERNEL_OTHER>.
+*/
+void
+kernel_times_reset(kernel_times *kt)
+{
+    ee_u8 i;
+    for (i = 0; i < NUM_KERNELS; i++)
+    {
+        kt->ticks[i]   = 0;
+        kt->cycles[i]  = 0;
+        kt->instret[i] = 0;
+    }
+    kt->current      = KERNEL_OTHER;
+    kt->last_ticks   = portable_ticks();
+    kt->last_cycles  = portable_cycles();
+    kt->last_instret = portable_instret();
+}
+/* Function: kernel_switch
+        Charge everything since the last switch to the running kernel, and
+   make <kernel> the running one.
+
+        Returns:
+        The kernel that was running, so the caller can switch back to it.
+*/
+ee_u8
+kernel_switch(kernel_times *kt, ee_u8 kernel)
+{
+    CORE_TICKS    ticks   = portable_ticks();
+    unsigned long cycles  = portable_cycles();
+    unsigned long instret = portable_instret();
+    ee_u8         prev    = kt->current;
+
+    kt->ticks[prev] += ticks - kt->last_ticks;
+    kt->cycles[prev] += cycles - kt->last_cycles;
+    kt->instret[prev] += instret - kt->last_instret;
+    kt->last_ticks   = ticks;
+    kt->last_cycles  = cycles;
+    kt->last_instret = instret;
+    kt->current      = kernel;
+    return prev;
+}
+#endif
+
 ee_u8
 check_data_types()
 {
@@ -27,6 +27,86 @@ Original Author: Shay Gal-on
 #define TOTAL_DATA_SIZE 2 * 1000
 #endif
 
+/* Configuration: SIZE_SWEEP
+        Define to the largest total data size in bytes (e.g. 268435456) to
+   replace the single run with a working set sweep. Starting at 2000 bytes the
+   data is initialized and timed at half octave steps (2000, 3000, 4000, 6000,
+   ...) up to SIZE_SWEEP, printing iterations/sec against footprint. The 2K and
+   6K points are validated against the known CRCs. The sweep runs on one
+   context, with data taken from <portable_malloc>.
+*/
+#ifndef SIZE_SWEEP
+#define SIZE_SWEEP 0
+#endif
+
+/* Configuration: LIST_CHASE
+        Define to an arena size in bytes (e.g. 268435456) to also measure the
+   load to use latency of list traversal. After the benchmark the arena, taken
+   from <portable_malloc>, is cut into slots of LIST_CHASE_STRIDE bytes and a
+   list with one cell per slot is linked in an order drawn from the first
+   seed. <core_list_find> and <core_list_reverse> are then timed over it and
+   reported in nanoseconds per hop. A stride of 64 puts each cell on a cache
+   line of its own, 4096 on a page of its own. Needs the pointer cell layout.
+*/
+#ifndef LIST_CHASE
+#define LIST_CHASE 0
+#endif
+#ifndef LIST_CHASE_STRIDE
+#define LIST_CHASE_STRIDE 64
+#endif
+
+/* Configuration: TRIALS
+        Define to the number of timed repetitions of the benchmark run. The
+   repetitions follow TRIALS_WARMUP untimed runs, and the text report adds the
+   min, median, mean, standard deviation and 95th percentile of the
+   iterations/sec of the trials, computed with integer arithmetic only. Trials
+   outside the 1.5 IQR fences are left out of mean and deviation, and the run
+   is flagged when their coefficient of variation exceeds TRIALS_MAX_CV, given
+   in tenths of a percent. The reported ticks are those of the median trial.
+*/
+#ifndef TRIALS
+#define TRIALS 0
+#endif
+#ifndef TRIALS_WARMUP
+#define TRIALS_WARMUP 1
+#endif
+#ifndef TRIALS_MAX_CV
+#define TRIALS_MAX_CV 20
+#endif
+
+/* Configuration: SCALE_SWEEP
+        After the timed run, repeat it with a growing number of contexts, up
+   to the count of the run (<MULTITHREAD> or M<n>), and print for each count
+   the iterations/sec, the iterations/sec per context, the parallel efficiency
+   against one context and the spread between the first and the last context
+   to finish. Every context keeps the iteration count of the timed run.
+
+        Valid values:
+        0 - No scaling sweep.
+        SCALE_POW2 - 1, 2, 4 ... contexts, and the full count.
+        SCALE_ALL - every count from 1 up.
+*/
+#define SCALE_POW2 1
+#define SCALE_ALL  2
+
+#ifndef SCALE_SWEEP
+#define SCALE_SWEEP 0
+#endif
+
+/* Configuration: SIMPOINT
+        Define to a number of iterations to run exactly that many (twice as
+   many <core_bench_list> calls) on one context instead of the timed run,
+   for simulation. A fingerprint of every iteration is printed: the running
+   crc, the crc of the iteration alone, and the cycles and retired
+   instructions of the iteration where the runtime can read them (see
+   <portable_cycles>). The smallest period after which the iterations repeat
+   is then searched, so that a window of one period can be simulated in
+   place of the whole run.
+*/
+#ifndef SIMPOINT
+#define SIMPOINT 0
+#endif
+
 #define SEED_ARG      0
 #define SEED_FUNC     1
 #define SEED_VOLATILE 2
@@ -35,8 +115,215 @@ Original Author: Shay Gal-on
 #define MEM_MALLOC 1
 #define MEM_STACK  2
 
+/* Configuration: KERNEL_TIMING
+        Define to 1 to account time separately to the list find, list sort,
+   matrix and state kernels inside <iterate>. The extra timer reads are part
+   of the timed region, so the score of such a build is not comparable.
+*/
+#ifndef KERNEL_TIMING
+#define KERNEL_TIMING 0
+#endif
+
+/* Configuration: CRC_METHOD
+        Engine used by the crc service functions. All engines produce the same
+   CRC values, but only CRC_BITWISE is the reference harness. Scores of the
+   other engines are reported as variant scores, see <CORE_VARIANT>.
+
+        Valid values:
+        CRC_BITWISE - bit serial loop, 8 steps per byte (default).
+        CRC_TABLE - 256 entry table, one lookup per byte.
+        CRC_SLICING - slicing-by-4 tables, one step per 16b or 32b value.
+        CRC_CLMUL - Barrett reduction with carry-less multiply, needs PCLMUL
+   (x86_64) or PMULL (AArch64) enabled in the compiler flags.
+*/
+#define CRC_BITWISE 0
+#define CRC_TABLE   1
+#define CRC_SLICING 2
+#define CRC_CLMUL   3
+
+#ifndef CRC_METHOD
+#define CRC_METHOD CRC_BITWISE
+#endif
+
+/* Configuration: MATRIX_SIMD
+        Define to 1 to also build hand vectorized versions of the matrix
+   kernels, for the SIMD extension enabled in the compiler flags: AVX-512BW,
+   AVX2 or SSE4.1 on x86, NEON on AArch64 and RVV on RISC-V. The timed run
+   keeps the scalar kernels, which are not auto-vectorized. After it, a tenth
+   of its iterations is run with the vector kernels and then with the scalar
+   ones: the vector kernels must reproduce the scalar CRCs, and both rates
+   are reported. The nolibc builds compile core_matrix.c without
+   -mgeneral-regs-only for it.
+*/
+#ifndef MATRIX_SIMD
+#define MATRIX_SIMD 0
+#endif
+
+/* Configuration: MATMUL_METHOD
+        Loop structure of the matrix by matrix kernels. All methods compute
+   the same results, so the CRCs do not change.
+
+        Valid values:
+        MATMUL_NAIVE - i, j, k loops reading B with stride N (default).
+        MATMUL_BLOCKED - loops tiled by MATMUL_TILE rows and columns.
+        MATMUL_TRANSPOSED - B is stored transposed by <core_init_matrix>, so
+   the inner loop reads both A and B sequentially.
+*/
+#define MATMUL_NAIVE      0
+#define MATMUL_BLOCKED    1
+#define MATMUL_TRANSPOSED 2
+
+#ifndef MATMUL_METHOD
+#define MATMUL_METHOD MATMUL_NAIVE
+#endif
+#ifndef MATMUL_TILE
+#define MATMUL_TILE 32
+#endif
+
+/* Configuration: MATRIX_N
+        Define to a matrix dimension (e.g. 512) to give the matrix kernel its
+   own static NxN block per context instead of a third of the data block.
+   The list and state kernels are unchanged. The seeds then no longer match a
+   known run, so the CRCs are not validated.
+*/
+#ifndef MATRIX_N
+#define MATRIX_N 0
+#endif
+
+/* Configuration: LIST_SOA
+        Define to 1 to lay the list out as arrays instead of cells of
+   pointers: 16b cell indices for the links, and the data16 and idx fields of
+   the data items in arrays of their own. The list holds the same items in
+   the same order, so the list CRCs do not change. A list is cut at 65534
+   items, which only the largest <SIZE_SWEEP> blocks reach.
+*/
+#ifndef LIST_SOA
+#define LIST_SOA 0
+#endif
+
+/* Configuration: LIST_SORT
+        Sort engine of the list benchmark.
+
+        Valid values:
+        LIST_SORT_MERGE - <core_list_mergesort>, merging lists of doubling
+   size through the list_cmp function pointer (default).
+        LIST_SORT_RUNS - comparators inlined, and the sort by idx merges the
+   natural runs of the list. The sort by data must keep the merges of
+   LIST_SORT_MERGE, as its order of comparisons feeds the CRC, so the CRCs do
+   not change. The work differs from CoreMark, so the score is reported as a
+   variant.
+*/
+#define LIST_SORT_MERGE 0
+#define LIST_SORT_RUNS  1
+
+#ifndef LIST_SORT
+#define LIST_SORT LIST_SORT_MERGE
+#endif
+
+/* Configuration: CALC_STATS
+        Define to 1 to count, per context over each <iterate> call, the hits
+   and misses of the <calc_func> cache and the kernels the misses dispatch:
+   state, matrix, or none for the other flags.
+*/
+#ifndef CALC_STATS
+#define CALC_STATS 0
+#endif
+
+/* Configuration: CALC_CACHE
+        Where <calc_func> keeps the results it computed.
+
+        Valid values:
+        CALC_CACHE_INPLACE - bit 7 and the low bits of the item data16, until
+   the sort by idx restores them (default).
+        CALC_CACHE_TABLE - a direct mapped table of CALC_CACHE_SIZE (a power
+   of 2) entries per context keyed by the data16 value, cleared at each list
+   benchmark call, data16 being left as is. Items of equal value share their
+   result and the list sees other data, so the work and the CRCs differ from
+   CoreMark. The mode is folded into the seedcrc, so they are not validated.
+*/
+#define CALC_CACHE_INPLACE 0
+#define CALC_CACHE_TABLE   1
+
+#ifndef CALC_CACHE
+#define CALC_CACHE CALC_CACHE_INPLACE
+#endif
+#ifndef CALC_CACHE_SIZE
+#define CALC_CACHE_SIZE 16
+#endif
+
+/* Configuration: STATE_ENGINE
+        Implementation of <core_state_transition>. Both engines run the same
+   machine and update the transition counts the same way, so the state CRCs
+   do not change.
+
+        Valid values:
+        STATE_SWITCH - switch on the state with branches on the input (default).
+        STATE_TABLE - byte class x state transition table, no data dependent
+   branches besides the end of token checks.
+*/
+#define STATE_SWITCH 0
+#define STATE_TABLE  1
+
+#ifndef STATE_ENGINE
+#define STATE_ENGINE STATE_SWITCH
+#endif
+
+/* Configuration: STATE_SIMD
+        Define to 1 to also scan the state input with vector compares, for
+   the SIMD extension enabled in the compiler flags: AVX-512BW (64 bytes at a
+   time), AVX2 (32) or SSE2 (16) on x86, NEON (16) on AArch64. The token ends
+   are found for a whole vector at once and the machine is replayed per token
+   from the byte classes. After the benchmark, the scan alone is timed
+   against the scalar one, must give the same counts, and is reported as a
+   parsing rate. The timed run keeps the scalar machine, so the score is
+   still a CoreMark 1.0 one. Not usable with -mgeneral-regs-only.
+*/
+#ifndef STATE_SIMD
+#define STATE_SIMD 0
+#endif
+
+/* Configuration: CORE_VARIANT
+        Derived from the options above, not to be defined. Set when any
+   kernel option other than its default is built in, or the kernels are timed
+   apart: the timed run then does other work than CoreMark 1.0, or does it
+   with other code, so its score is reported as a variant and never as a
+   CoreMark 1.0 score. The vector kernels of <MATRIX_SIMD> and <STATE_SIMD>
+   only run outside of the timed run, and do not count.
+*/
+#define CORE_VARIANT                                                \
+    ((CRC_METHOD != CRC_BITWISE) || (MATMUL_METHOD != MATMUL_NAIVE) \
+     || MATRIX_N || LIST_SOA || (LIST_SORT != LIST_SORT_MERGE)      \
+     || (CALC_CACHE != CALC_CACHE_INPLACE)                          \
+     || (STATE_ENGINE != STATE_SWITCH) || KERNEL_TIMING)
+
+/* Configuration: REPORT_FORMAT
+        Emit a machine readable record of the run after the text report. The
+   record is printed with <ee_printf> and integer formats only, so it is also
+   available without floating point.
+
+        Valid values:
+        REPORT_TEXT - text report only (default).
+        REPORT_JSON - one line JSON object.
+        REPORT_CSV - a CSV header line followed by one CSV line.
+*/
+#define REPORT_TEXT 0
+#define REPORT_JSON 1
+#define REPORT_CSV  2
+
+#ifndef REPORT_FORMAT
+#define REPORT_FORMAT REPORT_TEXT
+#endif
+
 #include "core_portme.h"
 
+/* region of interest markers, for ports that do not provide them */
+#ifndef ROI_ITERATION_BEGIN
+#define ROI_ITERATION_BEGIN(i)
+#endif
+#ifndef ROI_ITERATION_END
+#define ROI_ITERATION_END(i)
+#endif
+
 #if HAS_STDIO
 #include <stdio.h>
 #endif
@@ -78,6 +365,9 @@ ee_u16 crcu8(ee_u8 data, ee_u16 crc);
 ee_u16 crc16(ee_s16 newval, ee_u16 crc);
 ee_u16 crcu16(ee_u16 newval, ee_u16 crc);
 ee_u16 crcu32(ee_u32 newval, ee_u16 crc);
+#if (CRC_METHOD != CRC_BITWISE)
+void crc_init(void);
+#endif
 ee_u8  check_data_types(void);
 void * portable_malloc(ee_size_t size);
 void   portable_free(void *p);
@@ -97,11 +387,27 @@ typedef struct list_data_s
     ee_s16 idx;
 } list_data;
 
+#if LIST_SOA
+/* index of a list cell, LIST_NIL ending the list */
+typedef ee_u16 list_link;
+#define LIST_NIL 0xffff
+
+/* the whole list as arrays, cells and data items being indices in them */
+typedef struct list_head_s
+{
+    list_link *next;   /* per cell, the next cell */
+    list_link *info;   /* per cell, its data item */
+    ee_s16 *   data16; /* per data item */
+    ee_s16 *   idx;    /* per data item */
+    list_link  head;   /* first cell */
+} list_head;
+#else
 typedef struct list_head_s
 {
     struct list_head_s *next;
     struct list_data_s *info;
 } list_head;
+#endif
 
 /*matrix benchmark related stuff */
 #define MATDAT_INT 1
@@ -136,6 +442,51 @@ typedef enum CORE_STATE
     NUM_CORE_STATES
 } core_state_e;
 
+#if KERNEL_TIMING
+/* Kernels accounted by KERNEL_TIMING */
+#define KERNEL_LIST_FIND 0
+#define KERNEL_LIST_SORT 1
+#define KERNEL_MATRIX    2
+#define KERNEL_STATE     3
+#define KERNEL_OTHER     4
+#define NUM_KERNELS      5
+
+/* Exclusive time per kernel, counters are native width and may wrap on 32b */
+typedef struct KERNEL_TIMES_S
+{
+    CORE_TICKS    ticks[NUM_KERNELS];
+    unsigned long cycles[NUM_KERNELS];
+    unsigned long instret[NUM_KERNELS];
+    CORE_TICKS    last_ticks;
+    unsigned long last_cycles;
+    unsigned long last_instret;
+    ee_u8         current;
+} kernel_times;
+#endif
+
+#if CALC_STATS
+/* Kernels dispatched by <calc_func> misses */
+#define CALC_STATE  0
+#define CALC_MATRIX 1
+#define CALC_NONE   2
+
+typedef struct CALC_STATS_S
+{
+    ee_u32 hits;
+    ee_u32 misses;
+    ee_u32 dispatch[3];
+} calc_stats;
+#endif
+
+#if (CALC_CACHE == CALC_CACHE_TABLE)
+/* A <calc_func> result, value < 0 for an empty entry */
+typedef struct CALC_ENTRY_S
+{
+    ee_s16 key;
+    ee_s16 value;
+} calc_entry;
+#endif
+
 /* Helper structure to hold results */
 typedef struct RESULTS_S
 {
@@ -155,6 +506,18 @@ typedef struct RESULTS_S
     ee_u16 crcmatrix;
     ee_u16 crcstate;
     ee_s16 err;
+#if KERNEL_TIMING
+    kernel_times ktimes;
+#endif
+#if CALC_STATS
+    calc_stats cstats;
+#endif
+#if (CALC_CACHE == CALC_CACHE_TABLE)
+    calc_entry ccache[CALC_CACHE_SIZE];
+#endif
+#if SCALE_SWEEP
+    CORE_TICKS done; /* ticks from start_time to the end of <iterate> */
+#endif
     /* ultithread specific */
     core_portable port;
 } core_results;
@@ -163,11 +526,39 @@ typedef struct RESULTS_S
 #if (MULTITHREAD > 1)
 ee_u8 core_start_parallel(core_results *res);
 ee_u8 core_stop_parallel(core_results *res);
+#elif SCALE_SWEEP
+#error "SCALE_SWEEP needs MULTITHREAD > 1"
+#endif
+
+#if KERNEL_TIMING
+/* kernel time accounting */
+void  kernel_times_reset(kernel_times *kt);
+ee_u8 kernel_switch(kernel_times *kt, ee_u8 kernel);
+#endif
+#if KERNEL_TIMING || SIMPOINT
+unsigned long portable_cycles(void);
+unsigned long portable_instret(void);
+#endif
+#if KERNEL_TIMING || SCALE_SWEEP
+CORE_TICKS portable_ticks(void);
+#endif
+#if MATRIX_SIMD || STATE_SIMD || LIST_CHASE || SCALE_SWEEP || TRIALS
+void portable_start_clock(void);
+void portable_stop_clock(void);
 #endif
 
 /* list benchmark functions */
 list_head *core_list_init(ee_u32 blksize, list_head *memblock, ee_s16 seed);
 ee_u16     core_bench_list(core_results *res, ee_s16 finder_idx);
+#if LIST_CHASE
+list_head *core_list_chase_init(ee_u8 *arena,
+                                ee_u32 size,
+                                ee_u32 stride,
+                                ee_s16 seed,
+                                ee_u32 *cells);
+ee_u32     core_list_chase(list_head **list, ee_u32 passes, ee_u8 reverse);
+ee_u32     core_list_chase_hops(list_head *list);
+#endif
 
 /* state benchmark functions */
 void   core_init_state(ee_u32 size, ee_s16 seed, ee_u8 *p);
@@ -177,6 +568,14 @@ ee_u16 core_bench_state(ee_u32 blksize,
                         ee_s16 seed2,
                         ee_s16 step,
                         ee_u16 crc);
+#if STATE_SIMD
+ee_u16             core_scan_state(ee_u32  blksize,
+                                   ee_u8  *memblock,
+                                   ee_u32  passes,
+                                   ee_u8   vector,
+                                   ee_u32 *bytes);
+extern const char *state_simd_isa;
+#endif
 
 /* matrix benchmark functions */
 ee_u32 core_init_matrix(ee_u32      blksize,
@@ -184,3 +583,7 @@ ee_u32 core_init_matrix(ee_u32      blksize,
                         ee_s32      seed,
                         mat_params *p);
 ee_u16 core_bench_matrix(mat_params *p, ee_s16 seed, ee_u16 crc);
+#if MATRIX_SIMD
+extern ee_u8       matrix_simd;
+extern const char *matrix_simd_isa;
+#endif
@@ -1541,7 +1541,7 @@ static inline int write(int fd, const char * buf, int len)
 
 #ifdef DEBUGCON
 static inline void xxyy_debugcon_out_char(char c) {
-	*(volatile char*)(0x800000001fe002e0ull) = c;
+	DEBUGCON_PUTC(c);
 }
 
 static inline void xxyy_debugcon_out_str(const char * str) {
@@ -1561,6 +1561,70 @@ static inline void xxyy_debugcon_out_str_n(const char* str, int n){
 	{xxyy_debugcon_out_str("xxyy:" __FILE__ ":" __stringify(__LINE__) ":");xxyy_debugcon_out_str((char*)__func__);xxyy_debugcon_out_str("\n");}
 #endif
 
+#if (PRINT_BUFFER != PRINT_DIRECT) && !defined(DEBUGCON)
+#if (PRINT_BUFFER_SIZE < 1024) || (PRINT_BUFFER_SIZE & (PRINT_BUFFER_SIZE - 1))
+#error "PRINT_BUFFER_SIZE must be a power of 2, at least 1024"
+#endif
+/*
+ * Output ring. ee_print_head counts every byte printed, the ring holds the
+ * last PRINT_BUFFER_SIZE of them at ee_print_head % PRINT_BUFFER_SIZE.
+ * Bytes from print_tail up to ee_print_head are not written out yet.
+ */
+char ee_print_ring[PRINT_BUFFER_SIZE] __attribute__((used));
+unsigned long ee_print_head __attribute__((used));
+#if (PRINT_BUFFER == PRINT_BATCH)
+static unsigned long print_tail;
+
+struct print_iovec {
+	const void *base;
+	size_t len;
+};
+
+/* write the pending bytes, in two pieces when they wrap around the ring */
+static void print_flush(void)
+{
+	struct print_iovec iov[2];
+	unsigned long from = print_tail & (PRINT_BUFFER_SIZE - 1);
+	unsigned long len = ee_print_head - print_tail;
+	int cnt = 1;
+
+	if (len == 0)
+		return;
+	iov[0].base = ee_print_ring + from;
+	iov[0].len = len;
+	if (from + len > PRINT_BUFFER_SIZE) {
+		iov[0].len = PRINT_BUFFER_SIZE - from;
+		iov[1].base = ee_print_ring;
+		iov[1].len = len - iov[0].len;
+		cnt = 2;
+	}
+	my_syscall3(__NR_writev, 1, iov, cnt);
+	print_tail = ee_print_head;
+}
+#endif
+
+/* contexts may print concurrently (CORE_DEBUG), serialize the ring */
+static int print_lock;
+
+static void print_append(const char *buf, int n)
+{
+	unsigned long at;
+	int i;
+
+	while (__atomic_exchange_n(&print_lock, 1, __ATOMIC_ACQUIRE))
+		;
+#if (PRINT_BUFFER == PRINT_BATCH)
+	if (ee_print_head - print_tail + n > PRINT_BUFFER_SIZE)
+		print_flush();
+#endif
+	at = ee_print_head;
+	for (i = 0; i < n; i++, at++)
+		ee_print_ring[at & (PRINT_BUFFER_SIZE - 1)] = buf[i];
+	ee_print_head = at;
+	__atomic_store_n(&print_lock, 0, __ATOMIC_RELEASE);
+}
+#endif
+
 int
 ee_printf(const char *fmt, ...)
 {
@@ -1573,6 +1637,8 @@ ee_printf(const char *fmt, ...)
     va_end(args);
 #ifdef DEBUGCON
     xxyy_debugcon_out_str_n(buf, n);
+#elif (PRINT_BUFFER != PRINT_DIRECT)
+    print_append(buf, n);
 #else
     write(1, buf, n);
 #endif
@@ -1596,12 +1662,139 @@ void sys_exit(int status)
 	while(1); /* shut the "noreturn" warnings. */
 }
 
+#if GCOV_DUMP
+static void gcov_dump(void);
+#endif
+
 __attribute__((noreturn,unused))
 void exit(int status)
 {
+#if GCOV_DUMP
+	gcov_dump();
+#endif
+#if (PRINT_BUFFER == PRINT_BATCH) && !defined(DEBUGCON)
+	print_flush();
+#endif
 	sys_exit(status);
 }
 
+/*
+ * vDSO lookup, so clock_gettime() does not need to enter the kernel. The
+ * vDSO image is found through AT_SYSINFO_EHDR in the auxiliary vector, and
+ * its dynamic symbol table is scanned for the clock_gettime entry point.
+ */
+#include <elf.h>
+
+#if __SIZEOF_LONG__ == 8
+#define ElfW(type) Elf64_##type
+#define ELFW_ST_TYPE(info) ELF64_ST_TYPE(info)
+#else
+#define ElfW(type) Elf32_##type
+#define ELFW_ST_TYPE(info) ELF32_ST_TYPE(info)
+#endif
+
+#if defined(__aarch64__)
+#define VDSO_CLOCK_GETTIME "__kernel_clock_gettime"
+#else
+#define VDSO_CLOCK_GETTIME "__vdso_clock_gettime"
+#endif
+
+static int (*vdso_clock_gettime)(clockid_t, struct timespec *);
+
+static int vdso_strcmp(const char *a, const char *b)
+{
+	while (*a && *a == *b) {
+		a++;
+		b++;
+	}
+	return (unsigned char)*a - (unsigned char)*b;
+}
+
+static void *vdso_sym(const ElfW(Ehdr) *ehdr, const char *name)
+{
+	const ElfW(Phdr) *phdr = (const void *)((const char *)ehdr + ehdr->e_phoff);
+	const ElfW(Dyn) *dyn = NULL;
+	const ElfW(Sym) *symtab = NULL;
+	const char *strtab = NULL;
+	const ElfW(Word) *hash = NULL;
+	const ElfW(Word) *gnu_hash = NULL;
+	unsigned long load_offset = 0, nsyms = 0, i;
+	int found_load = 0;
+
+	for (i = 0; i < ehdr->e_phnum; i++) {
+		if (phdr[i].p_type == PT_LOAD && !found_load) {
+			found_load = 1;
+			load_offset = (unsigned long)ehdr + phdr[i].p_offset - phdr[i].p_vaddr;
+		} else if (phdr[i].p_type == PT_DYNAMIC) {
+			dyn = (const void *)((const char *)ehdr + phdr[i].p_offset);
+		}
+	}
+	if (!found_load || !dyn)
+		return NULL;
+
+	for (; dyn->d_tag != DT_NULL; dyn++) {
+		const void *addr = (const void *)(dyn->d_un.d_ptr + load_offset);
+
+		if (dyn->d_tag == DT_SYMTAB)
+			symtab = addr;
+		else if (dyn->d_tag == DT_STRTAB)
+			strtab = addr;
+		else if (dyn->d_tag == DT_HASH)
+			hash = addr;
+		else if (dyn->d_tag == DT_GNU_HASH)
+			gnu_hash = addr;
+	}
+	if (!symtab || !strtab)
+		return NULL;
+
+	if (hash) {
+		nsyms = hash[1];
+	} else if (gnu_hash) {
+		/* walk to the end of the chain of the highest bucket */
+		const ElfW(Word) nbuckets = gnu_hash[0];
+		const ElfW(Word) symoffset = gnu_hash[1];
+		const ElfW(Word) *buckets = gnu_hash + 4 +
+			gnu_hash[2] * (sizeof(ElfW(Addr)) / sizeof(ElfW(Word)));
+		const ElfW(Word) *chain = buckets + nbuckets - symoffset;
+
+		for (i = 0; i < nbuckets; i++)
+			if (buckets[i] > nsyms)
+				nsyms = buckets[i];
+		if (nsyms)
+			while (!(chain[nsyms] & 1))
+				nsyms++;
+		nsyms++;
+	}
+
+	for (i = 0; i < nsyms; i++) {
+		const ElfW(Sym) *sym = &symtab[i];
+
+		if (ELFW_ST_TYPE(sym->st_info) != STT_FUNC ||
+		    sym->st_shndx == SHN_UNDEF)
+			continue;
+		if (!vdso_strcmp(strtab + sym->st_name, name))
+			return (void *)(sym->st_value + load_offset);
+	}
+	return NULL;
+}
+
+static void vdso_init(const unsigned long *auxv)
+{
+	for (; auxv && auxv[0] != AT_NULL; auxv += 2) {
+		if (auxv[0] == AT_SYSINFO_EHDR && auxv[1]) {
+			vdso_clock_gettime = vdso_sym((const void *)auxv[1],
+						      VDSO_CLOCK_GETTIME);
+			return;
+		}
+	}
+}
+
+#ifdef USE_TSC
+static unsigned long long get_tsc_hz(void);
+#endif
+
+/* used: only called from the _start assembly, which LTO does not see */
+__attribute__((used))
 void _start_c(long *sp)
 {
 	long argc;
@@ -1609,7 +1802,7 @@ void _start_c(long *sp)
 	char **envp;
 	const unsigned long *auxv;
 	/* silence potential warning: conflicting types for 'main' */
-	int _nolibc_main(int, char **, char **) __asm__ ("main");
+	int _nolibc_main(int, char **) __asm__ ("main");
 
 	/* initialize stack protector */
 	__stack_chk_init();
@@ -1643,30 +1836,98 @@ void _start_c(long *sp)
 		;
 	_auxv = auxv;
 
+	/* find the vDSO clock_gettime() */
+	vdso_init(_auxv);
+
+#ifdef USE_TSC
+	/* calibrate the counter now, not in the first timed region */
+	get_tsc_hz();
+#endif
+
 	/* go to application */
-	exit(_nolibc_main(argc, argv, envp));
+	exit(_nolibc_main(argc, argv));
 }
 
+/* 64 bit division without libgcc on 32 bit targets */
+static unsigned long long udiv64(unsigned long long n, unsigned long long d)
+{
+#if __SIZEOF_LONG__ >= 8
+    return d ? n / d : 0;
+#else
+    unsigned long long q = 0, bit = 1;
+
+    if (!d)
+        return 0;
+    while (!(d >> 63) && (d << 1) <= n) {
+        d <<= 1;
+        bit <<= 1;
+    }
+    while (bit) {
+        if (n >= d) {
+            n -= d;
+            q |= bit;
+        }
+        d >>= 1;
+        bit >>= 1;
+    }
+    return q;
+#endif
+}
+
+/*
+ * get_tsc() reads a constant rate counter, tsc_hz_firmware() returns its rate
+ * as reported by the cpu, or 0 when it has to be measured.
+ */
 #if defined(__x86_64__) || defined(i386)
 #include <x86intrin.h>
+#include <cpuid.h>
 
-//12700k
-#define TSC_HZ 3600000000
 static inline long long get_tsc(void) {
     unsigned int temp;
     return __rdtscp(&temp);
 }
 
+/* 12700k: 5.0GHz P-core over a 3.6GHz TSC */
+#ifndef TSC_CYCLE_MUL
+#define TSC_CYCLE_MUL 25
+#define TSC_CYCLE_DIV 18
+#endif
 static inline long long
 __attribute__((always_inline))
 get_cycle(void) {
-    return (long long)(get_tsc() * 1.38888888888888888888);
+    return udiv64(get_tsc() * TSC_CYCLE_MUL, TSC_CYCLE_DIV);
+}
+
+/* CPUID 0x15 crystal ratio, 0x16 base frequency, or the hypervisor leaf */
+static __attribute__((unused))
+unsigned long long tsc_hz_firmware(void) {
+    unsigned int eax, ebx, ecx, edx;
+    unsigned int max = __get_cpuid_max(0, 0);
+
+    if (max >= 0x15) {
+        __cpuid_count(0x15, 0, eax, ebx, ecx, edx);
+        if (eax && ebx && ecx)
+            return udiv64((unsigned long long)ecx * ebx, eax);
+        if (eax && ebx && max >= 0x16) {
+            __cpuid_count(0x16, 0, eax, ebx, ecx, edx);
+            if (eax & 0xffff)
+                return (eax & 0xffff) * 1000000ull;
+        }
+    }
+    __cpuid(1, eax, ebx, ecx, edx);
+    if (ecx & (1u << 31)) {
+        __cpuid(0x40000000, eax, ebx, ecx, edx);
+        if (eax >= 0x40000010) {
+            __cpuid(0x40000010, eax, ebx, ecx, edx);
+            if (eax)
+                return eax * 1000ull;
+        }
+    }
+    return 0;
 }
 
 #elif defined(__loongarch__)
 #include <larchintrin.h>
-// 3a5000
-#define TSC_HZ 100000000
 static inline long long get_tsc(void) {
     long long r;
     asm volatile(
@@ -1678,6 +1939,7 @@ static inline long long get_tsc(void) {
     return r;
 }
 
+// 3a5000
 static inline long long
 __attribute__((always_inline))
 get_cycle(void) {
@@ -1685,9 +1947,19 @@ get_cycle(void) {
     return get_tsc() * 25;
 }
 
+/* constant timer: CPUCFG4 crystal Hz, CPUCFG5 multiplier and divider */
+static __attribute__((unused))
+unsigned long long tsc_hz_firmware(void) {
+    unsigned int freq = __cpucfg(4);
+    unsigned int mul = __cpucfg(5) & 0xffff;
+    unsigned int div = (__cpucfg(5) >> 16) & 0xffff;
+
+    if (!freq || !mul || !div)
+        return 0;
+    return udiv64((unsigned long long)freq * mul, div);
+}
+
 #elif defined(__riscv)
-// d1 c906
-#define TSC_HZ 24000000
 static inline long long get_tsc(void) {
     long long r;
     asm volatile(
@@ -1725,30 +1997,374 @@ get_instret(void) {
     return r;
 }
 
+/* timebase-frequency only lives in the device tree */
+static __attribute__((unused))
+unsigned long long tsc_hz_firmware(void) {
+    return 0;
+}
+
 #elif defined(__aarch64__)
 
-#define TSC_HZ 24000000
 static inline long long get_tsc(void) {
-    struct timespec _t;
-    my_syscall2(__NR_clock_gettime, 0, &_t);
-    return _t.tv_sec * 1000000000ll + _t.tv_nsec;
+    long long r;
+    asm volatile(
+    "isb \n\t"
+    "mrs %0, cntvct_el0 \n\t"
+    :"=r"(r)
+    :
+    :"memory"
+    );
+    return r;
+}
+
+static __attribute__((unused))
+unsigned long long tsc_hz_firmware(void) {
+    unsigned long long r;
+    asm volatile("mrs %0, cntfrq_el0" : "=r"(r));
+    return r;
 }
 
 #else
     #warning "no intrin.h support"
 #endif
 
+/* Define: TSC_CALIBRATE_NS
+        Length of the CLOCK_MONOTONIC_RAW window used to measure the counter
+   rate when the cpu does not report it. The measurement is done once at
+   startup, in _start_c.
+*/
+#ifndef TSC_CALIBRATE_NS
+#define TSC_CALIBRATE_NS 50000000
+#endif
+
+static unsigned long long tsc_hz;
+
+static __attribute__((unused))
+unsigned long long tsc_hz_measure(void) {
+    struct timespec t0, t1;
+    long long c0, c1, ns;
+
+    my_syscall2(__NR_clock_gettime, CLOCK_MONOTONIC_RAW, &t0);
+    c0 = get_tsc();
+    do {
+        my_syscall2(__NR_clock_gettime, CLOCK_MONOTONIC_RAW, &t1);
+        c1 = get_tsc();
+        ns = (t1.tv_sec - t0.tv_sec) * 1000000000ll + (t1.tv_nsec - t0.tv_nsec);
+    } while (ns < TSC_CALIBRATE_NS);
+    return udiv64((unsigned long long)(c1 - c0) * 1000000000ull, ns);
+}
+
+/* counter rate in Hz, -DTSC_HZ=<n> skips the calibration */
+static __attribute__((unused))
+unsigned long long get_tsc_hz(void) {
+    if (!tsc_hz) {
+#ifdef TSC_HZ
+        tsc_hz = TSC_HZ;
+#else
+        tsc_hz = tsc_hz_firmware();
+        if (!tsc_hz)
+            tsc_hz = tsc_hz_measure();
+#endif
+    }
+    return tsc_hz;
+}
+
+#if KERNEL_TIMING || SIMPOINT
+/* x86 has no user readable core cycle counter, report TSC reference cycles */
+unsigned long portable_cycles(void)
+{
+#if defined(__x86_64__) || defined(i386)
+    return get_tsc();
+#elif defined(__loongarch__) || defined(__riscv)
+    return get_cycle();
+#else
+    return 0;
+#endif
+}
+
+unsigned long portable_instret(void)
+{
+#if defined(__riscv)
+    return get_instret();
+#else
+    return 0;
+#endif
+}
+#endif
+
 int clock_gettime(clockid_t clockid, struct timespec *tp) {
 #ifdef USE_TSC
-    long long t = get_tsc();
-    tp->tv_sec = t / 1000000000;
-    tp->tv_nsec = t % 1000000000;
+    unsigned long long hz = get_tsc_hz(), t = get_tsc();
+    unsigned long long sec = udiv64(t, hz);
+    tp->tv_sec = sec;
+    tp->tv_nsec = udiv64((t - sec * hz) * 1000000000ull, hz);
 #else
+    if (vdso_clock_gettime)
+        return vdso_clock_gettime(clockid, tp);
     my_syscall2(__NR_clock_gettime, clockid, tp);
 #endif
     return 0;
 }
 
+#if USE_PERF
+#include <linux/perf_event.h>
+
+struct perf_read_value {
+    unsigned long long value;
+    unsigned long long time_enabled;
+    unsigned long long time_running;
+};
+
+static const struct {
+    const char *name;
+    unsigned int type;
+    unsigned long long config;
+} perf_events[NUM_PERF_EVENTS] = {
+    [PERF_CYCLES]        = { "cycles",       PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    [PERF_INSTRUCTIONS]  = { "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    [PERF_BRANCH_MISSES] = { "branch-miss",  PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    [PERF_L1D_MISSES]    = { "L1D miss",     PERF_TYPE_HW_CACHE,
+        PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    [PERF_LLC_MISSES]    = { "LLC miss",     PERF_TYPE_HW_CACHE,
+        PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    [PERF_DTLB_MISSES]   = { "dTLB miss",    PERF_TYPE_HW_CACHE,
+        PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+};
+
+/* counts of one thread, scaled to the time the events were enabled */
+struct perf_counts {
+    unsigned long long value[NUM_PERF_EVENTS];
+    unsigned char counted[NUM_PERF_EVENTS];
+    unsigned char multiplexed[NUM_PERF_EVENTS];
+};
+
+static int perf_fd[NUM_PERF_EVENTS];
+static int perf_opened;
+static struct perf_counts perf_total;
+static int perf_threads;
+
+static char *perf_u64_str(char *buf, unsigned long long v)
+{
+    char tmp[24];
+    int i = 0, n = 0;
+
+    do {
+        unsigned long long q = udiv64(v, 10);
+        tmp[i++] = '0' + (int)(v - q * 10);
+        v = q;
+    } while (v);
+    while (i)
+        buf[n++] = tmp[--i];
+    buf[n] = 0;
+    return buf;
+}
+
+/* print num/den with two decimals */
+static void perf_print_ratio(const char *name, unsigned long long num,
+                             unsigned long long den, unsigned long long scale)
+{
+    char buf[24];
+    unsigned long long r = udiv64(num * scale * 100, den);
+    unsigned long long q = udiv64(r, 100);
+
+    ee_printf("%-17s: %s.%02d\n", name, perf_u64_str(buf, q), (int)(r - q * 100));
+}
+
+/*
+ * Events count the calling thread only. Inherited events would fold the
+ * clone threads in, but their counts reach the parent only when the kernel
+ * tears a thread down, after the join has already returned, and a reset
+ * leaves the counts of earlier threads in place. So each context counts
+ * itself (perf_context) and the counts are added up after the join. Events
+ * the host cannot count are left closed and reported as n/a.
+ */
+static void perf_events_open(int *fd)
+{
+    struct perf_event_attr attr;
+    int i;
+
+    for (i = 0; i < NUM_PERF_EVENTS; i++) {
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = perf_events[i].type;
+        attr.config = perf_events[i].config;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+                           PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd[i] = my_syscall5(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+}
+
+static void perf_events_enable(const int *fd)
+{
+    int i;
+
+    for (i = 0; i < NUM_PERF_EVENTS; i++) {
+        if (fd[i] < 0)
+            continue;
+        my_syscall3(__NR_ioctl, fd[i], PERF_EVENT_IOC_RESET, 0);
+        my_syscall3(__NR_ioctl, fd[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+/*
+ * An event multiplexed with others only runs part of the time it is
+ * enabled, its count is extrapolated to the whole time: value * enabled /
+ * running, with the ratio in 16.16 fixed point to stay within 64b.
+ */
+static unsigned long long perf_scale(const struct perf_read_value *v)
+{
+    unsigned long long f;
+
+    if (v->time_running >= v->time_enabled)
+        return v->value;
+    f = udiv64(v->time_enabled << 16, v->time_running);
+    return (v->value >> 16) * f + (((v->value & 0xffff) * f) >> 16);
+}
+
+static void perf_events_read(const int *fd, struct perf_counts *c)
+{
+    struct perf_read_value v;
+    int i;
+
+    for (i = 0; i < NUM_PERF_EVENTS; i++)
+        if (fd[i] >= 0)
+            my_syscall3(__NR_ioctl, fd[i], PERF_EVENT_IOC_DISABLE, 0);
+    for (i = 0; i < NUM_PERF_EVENTS; i++) {
+        c->counted[i] = fd[i] >= 0 &&
+            my_syscall3(__NR_read, fd[i], &v, sizeof(v)) == sizeof(v) &&
+            v.time_running != 0;
+        c->value[i] = c->counted[i] ? perf_scale(&v) : 0;
+        c->multiplexed[i] = c->counted[i] && v.time_running < v.time_enabled;
+    }
+}
+
+#if (MULTITHREAD > 1) && USE_CLONE
+static struct perf_context_s {
+    core_results *res;
+    struct perf_counts counts;
+} perf_context_slot[MULTITHREAD];
+
+/* Function: perf_context
+        Entry of a clone thread with USE_PERF: count the events of this
+   thread around its context, and leave the counts in its slot for
+   perf_counters_stop.
+*/
+static void *perf_context(void *arg)
+{
+    struct perf_context_s *ctx = arg;
+    int fd[NUM_PERF_EVENTS];
+    int i;
+
+    perf_events_open(fd);
+    perf_events_enable(fd);
+    PARALLEL_ENTRY(ctx->res);
+    perf_events_read(fd, &ctx->counts);
+    for (i = 0; i < NUM_PERF_EVENTS; i++)
+        if (fd[i] >= 0)
+            my_syscall1(__NR_close, fd[i]);
+    return NULL;
+}
+#endif
+
+void perf_counters_start(void)
+{
+    if (!perf_opened) {
+        perf_events_open(perf_fd);
+        perf_opened = 1;
+    }
+    perf_threads = 0;
+    perf_events_enable(perf_fd);
+}
+
+/* called after the contexts have been joined, their slots are final */
+void perf_counters_stop(void)
+{
+    perf_events_read(perf_fd, &perf_total);
+#if (MULTITHREAD > 1) && USE_CLONE
+    {
+        int t, i;
+
+        for (t = 0; t < perf_threads; t++) {
+            struct perf_counts *c = &perf_context_slot[t].counts;
+
+            for (i = 0; i < NUM_PERF_EVENTS; i++) {
+                perf_total.value[i] += c->value[i];
+                perf_total.counted[i] &= c->counted[i];
+                perf_total.multiplexed[i] |= c->multiplexed[i];
+            }
+        }
+    }
+#endif
+}
+
+#if TRIALS
+/* counts of each trial, so that those of the median trial can be reported */
+static struct perf_counts perf_trial[TRIALS];
+
+void perf_counters_save(int trial)
+{
+    perf_trial[trial] = perf_total;
+}
+
+void perf_counters_restore(int trial)
+{
+    perf_total = perf_trial[trial];
+}
+#endif
+
+/* count of one event as a decimal string, -1 if the event was not counted */
+int perf_counter_read(int event, char *buf)
+{
+    if (!perf_total.counted[event])
+        return -1;
+    perf_u64_str(buf, perf_total.value[event]);
+    return 0;
+}
+
+/* counts of the reported timed region, and the derived ratios */
+void perf_counters_report(void)
+{
+    static const struct {
+        const char *name;
+        int event;
+    } mpki[] = {
+        { "Branch MPKI", PERF_BRANCH_MISSES },
+        { "L1D MPKI",    PERF_L1D_MISSES },
+        { "LLC MPKI",    PERF_LLC_MISSES },
+        { "dTLB MPKI",   PERF_DTLB_MISSES },
+    };
+    unsigned long long cycles = perf_total.value[PERF_CYCLES];
+    unsigned long long instructions = perf_total.value[PERF_INSTRUCTIONS];
+    char buf[24];
+    int i;
+
+    for (i = 0; i < NUM_PERF_EVENTS; i++) {
+        if (!perf_total.counted[i])
+            ee_printf("Perf %-12s: n/a\n", perf_events[i].name);
+        else
+            ee_printf("Perf %-12s: %s%s\n", perf_events[i].name,
+                      perf_u64_str(buf, perf_total.value[i]),
+                      perf_total.multiplexed[i] ? " (multiplexed, scaled)" : "");
+    }
+    if (!perf_total.counted[PERF_CYCLES] ||
+        !perf_total.counted[PERF_INSTRUCTIONS] ||
+        cycles == 0 || instructions == 0)
+        return;
+    perf_print_ratio("IPC", instructions, cycles, 1);
+    perf_print_ratio("CPI", cycles, instructions, 1);
+    for (i = 0; i < (int)(sizeof(mpki) / sizeof(mpki[0])); i++)
+        if (perf_total.counted[mpki[i].event])
+            perf_print_ratio(mpki[i].name, perf_total.value[mpki[i].event],
+                             instructions, 1000);
+}
+#endif
+
 static __attribute__((unused))
 void *sys_mmap(void *addr, size_t length, int prot, int flags, int fd,
 	       off_t offset)
@@ -1805,7 +2421,8 @@ void *sys_mmap(void *addr, size_t length, int prot, int flags, int fd,
  * MAP_FAILED.
  */
 
-static __attribute__((unused))
+/* not static, libgcov refers to it (GCOV_DUMP) */
+__attribute__((unused))
 void *mmap(void *addr, size_t length, int prot, int flags, int fd, off_t offset)
 {
 	void *ret = sys_mmap(addr, length, prot, flags, fd, offset);
@@ -1817,19 +2434,458 @@ void *mmap(void *addr, size_t length, int prot, int flags, int fd, off_t offset)
 	return ret;
 }
 
- __attribute__((unused))
+static __attribute__((unused))
+int munmap(void *addr, size_t length)
+{
+	return my_syscall2(__NR_munmap, addr, length);
+}
+
+#if GCOV_DUMP
+#if __GNUC__ < 12
+#error "GCOV_DUMP needs __gcov_info_to_gcda from GCC 12 or later"
+#endif
+#include <linux/fcntl.h>
+/*
+ * Profile dump for -fprofile-info-section=gcov_info builds. The compiler
+ * puts a pointer to the gcov_info of each object in the gcov_info section,
+ * which the linker brackets with __start_gcov_info and __stop_gcov_info.
+ * __gcov_info_to_gcda serializes one object through the callbacks below,
+ * which open the .gcda file it names and write to it. Existing data is
+ * replaced, not merged: one profile run makes one profile.
+ */
+struct gcov_info;
+
+extern const struct gcov_info *const __start_gcov_info[] __attribute__((weak));
+extern const struct gcov_info *const __stop_gcov_info[] __attribute__((weak));
+
+void __gcov_info_to_gcda(const struct gcov_info *info,
+			 void (*filename_fn)(const char *, void *),
+			 void (*dump_fn)(const void *, unsigned, void *),
+			 void *(*allocate_fn)(unsigned, void *),
+			 void *arg);
+
+/* referenced by each gcov_info, only called by libgcov to merge into an
+ * existing .gcda file */
+void __gcov_merge_add(void *counters, unsigned n_counters)
+{
+	(void)counters;
+	(void)n_counters;
+}
+
+/* referenced by __gcov_info_to_gcda on a failed check */
+__attribute__((noreturn))
+void abort(void)
+{
+	my_syscall1(__NR_exit, 134);
+	while(1);
+}
+
+static void gcov_open(const char *name, void *arg)
+{
+	int *fd = arg;
+
+	*fd = my_syscall4(__NR_openat, AT_FDCWD, name,
+			  O_WRONLY | O_CREAT | O_TRUNC, 0644);
+}
+
+static void gcov_write(const void *data, unsigned len, void *arg)
+{
+	int *fd = arg;
+
+	if (*fd >= 0)
+		write(*fd, data, len);
+}
+
+/* only for value profiles, which the build does not collect */
+static void *gcov_allocate(unsigned len, void *arg)
+{
+	void *p = mmap(NULL, len, PROT_READ | PROT_WRITE,
+		       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	(void)arg;
+	return p == MAP_FAILED ? NULL : p;
+}
+
+static void gcov_dump(void)
+{
+	const struct gcov_info *const *info;
+	int fd;
+
+	for (info = __start_gcov_info; info < __stop_gcov_info; info++) {
+		fd = -1;
+		__gcov_info_to_gcda(*info, gcov_open, gcov_write,
+				    gcov_allocate, &fd);
+		if (fd >= 0)
+			my_syscall1(__NR_close, fd);
+		else
+			ee_printf("Profile dump failed: %d\n", fd);
+	}
+}
+#endif
+
+#if (MULTITHREAD > 1) && NUMA_PLACE
+/*
+ * Generic system call entry with the libc prototype, for the parts of the
+ * port that make raw system calls (NUMA_PLACE). Unlike libc it returns
+ * -errno on failure, callers only test for 0 or a negative value.
+ */
+long syscall(long nr, ...)
+{
+	long a1, a2, a3, a4, a5, a6;
+	va_list args;
+
+	va_start(args, nr);
+	a1 = va_arg(args, long);
+	a2 = va_arg(args, long);
+	a3 = va_arg(args, long);
+	a4 = va_arg(args, long);
+	a5 = va_arg(args, long);
+	a6 = va_arg(args, long);
+	va_end(args);
+	return my_syscall6(nr, a1, a2, a3, a4, a5, a6);
+}
+#endif
+
+#define MADV_HUGEPAGE	14		/* Worth backing with hugepages */
+
+static __attribute__((unused))
+int madvise(void *addr, size_t length, int advice)
+{
+	return my_syscall3(__NR_madvise, addr, length, advice);
+}
+
+/*
+ * Each block starts with a header that records the mapping, so free() can
+ * give all of it back with munmap. The header is a whole cache line to keep
+ * the returned pointer line aligned.
+ */
+#define MALLOC_HDR	64
+
+struct malloc_hdr {
+	void *base;
+	size_t length;
+};
+
+#if USE_HUGEPAGES
+#define HUGE_PAGE_SIZE	(2UL << 20)
+
+/*
+ * Map len bytes on 2 MiB pages, prefaulted so that no page fault or page
+ * clearing lands in the timed region. Explicit hugetlb pages are tried first.
+ * Without a hugetlb pool, fall back to a 2 MiB aligned anonymous mapping with
+ * MADV_HUGEPAGE, touched page by page after the advice so that the faults
+ * allocate transparent huge pages.
+ */
+static void *huge_map(size_t *len)
+{
+	char *p, *q, *end;
+	volatile char *v;
+	size_t off;
+
+	*len = (*len + HUGE_PAGE_SIZE - 1) & -HUGE_PAGE_SIZE;
+	p = mmap(NULL, *len, PROT_READ|PROT_WRITE,
+		 MAP_ANONYMOUS|MAP_PRIVATE|MAP_HUGETLB|MAP_POPULATE, -1, 0);
+	if (p != MAP_FAILED)
+		return p;
+
+	p = mmap(NULL, *len + HUGE_PAGE_SIZE, PROT_READ|PROT_WRITE,
+		 MAP_ANONYMOUS|MAP_PRIVATE, -1, 0);
+	if (p == MAP_FAILED)
+		return p;
+	q   = (char *)(((unsigned long)p + HUGE_PAGE_SIZE - 1) & -HUGE_PAGE_SIZE);
+	end = p + *len + HUGE_PAGE_SIZE;
+	if (q != p)
+		munmap(p, q - p);
+	if (end != q + *len)
+		munmap(q + *len, end - (q + *len));
+	madvise(q, *len, MADV_HUGEPAGE);
+	for (v = q, off = 0; off < *len; off += 4096)
+		v[off] = 0;
+	return q;
+}
+#endif
+
+__attribute__((unused))
 void *malloc(size_t len)
 {
+	struct malloc_hdr *hdr;
+	void *heap;
+
+	len += MALLOC_HDR;
+#if USE_HUGEPAGES
+	heap = huge_map(&len);
+#else
 	len  = (len + 4095UL) & -4096UL;
-	void* heap = mmap(NULL, len, PROT_READ|PROT_WRITE, MAP_ANONYMOUS|MAP_PRIVATE,
+	heap = mmap(NULL, len, PROT_READ|PROT_WRITE, MAP_ANONYMOUS|MAP_PRIVATE,
 		    -1, 0);
+#endif
 	if (__builtin_expect(heap == MAP_FAILED, 0))
 		return NULL;
-	return heap;
+	hdr = heap;
+	hdr->base   = heap;
+	hdr->length = len;
+	return (char *)heap + MALLOC_HDR;
 }
 
 __attribute__((unused))
 void free(void *ptr)
 {
+	struct malloc_hdr *hdr;
+
+	if (!ptr)
+		return;
+	hdr = (struct malloc_hdr *)((char *)ptr - MALLOC_HDR);
+	munmap(hdr->base, hdr->length);
+}
+
+#if (MULTITHREAD > 1) && USE_CLONE
+/* flags for clone */
+#define CLONE_VM		0x00000100	/* set if VM shared between processes */
+#define CLONE_FS		0x00000200	/* set if fs info shared between processes */
+#define CLONE_FILES		0x00000400	/* set if open files shared between processes */
+#define CLONE_SIGHAND		0x00000800	/* set if signal handlers and blocked signals shared */
+#define CLONE_THREAD		0x00010000	/* Same thread group? */
+#define CLONE_SYSVSEM		0x00040000	/* share system V SEM_UNDO semantics */
+#define CLONE_PARENT_SETTID	0x00100000	/* set the TID in the parent */
+#define CLONE_CHILD_CLEARTID	0x00200000	/* clear the TID in the child */
+
+#define CLONE_THREAD_FLAGS \
+	(CLONE_VM | CLONE_FS | CLONE_FILES | CLONE_SIGHAND | CLONE_THREAD | \
+	 CLONE_SYSVSEM | CLONE_PARENT_SETTID | CLONE_CHILD_CLEARTID)
+
+#define FUTEX_WAIT		0
+
+#ifndef CLONE_STACK_SIZE
+#define CLONE_STACK_SIZE 0x10000
+#endif
+
+static char clone_stack[MULTITHREAD][CLONE_STACK_SIZE] __attribute__((aligned(16)));
+static int clone_active;
+
+/*
+ * Start fn(arg) in a new thread running on stack_top. The kernel stores the
+ * thread id in *tid before the child runs, and clears it (with a futex wake)
+ * once the child has exited and no longer touches its stack.
+ *
+ * fn and arg are handed over on the child stack, the child pops them, calls
+ * fn and exits the thread with the raw exit syscall. Only the parent returns.
+ */
+static long clone_thread(void *(*fn)(void *), void *arg, char *stack_top,
+			 volatile int *tid)
+{
+	long *sp = (long *)stack_top;
 
+#if defined(__x86_64__)
+	sp -= 2;
+	sp[0] = (long)fn;
+	sp[1] = (long)arg;
+	register long _num  __asm__ ("rax") = __NR_clone;
+	register long _arg1 __asm__ ("rdi") = CLONE_THREAD_FLAGS;
+	register long _arg2 __asm__ ("rsi") = (long)sp;
+	register long _arg3 __asm__ ("rdx") = (long)tid;
+	register long _arg4 __asm__ ("r10") = (long)tid;
+	register long _arg5 __asm__ ("r8")  = 0;
+
+	__asm__ volatile (
+		"syscall\n"
+		"test %%rax, %%rax\n"
+		"jnz  1f\n"
+		"pop  %%rax\n"            /* fn                                  */
+		"pop  %%rdi\n"            /* arg, %rsp is 16-byte aligned again  */
+		"xor  %%ebp, %%ebp\n"     /* zero the stack frame                */
+		"call *%%rax\n"
+		"xor  %%edi, %%edi\n"
+		"mov  %[nr_exit], %%eax\n"
+		"syscall\n"
+		"hlt\n"
+		"1:\n"
+		: "=a"(_num)
+		: "r"(_arg1), "r"(_arg2), "r"(_arg3), "r"(_arg4), "r"(_arg5),
+		  "0"(_num), [nr_exit]"i"(__NR_exit)
+		: "rcx", "r11", "memory", "cc"
+	);
+	return _num;
+#elif defined(__i386__)
+	/* keep %esp 16-byte aligned on the call, with arg pushed */
+	sp -= 5;
+	sp[0] = (long)fn;
+	sp[1] = (long)arg;
+	long _ret = __NR_clone;
+
+	/* clone(flags, newsp, ptid, tls, ctid) */
+	__asm__ volatile (
+		"int  $0x80\n"
+		"test %%eax, %%eax\n"
+		"jnz  1f\n"
+		"pop  %%eax\n"            /* fn, arg stays on the stack          */
+		"xor  %%ebp, %%ebp\n"     /* zero the stack frame                */
+		"call *%%eax\n"
+		"xor  %%ebx, %%ebx\n"
+		"mov  %[nr_exit], %%eax\n"
+		"int  $0x80\n"
+		"hlt\n"
+		"1:\n"
+		: "+a"(_ret)
+		: "b"(CLONE_THREAD_FLAGS), "c"(sp), "d"(tid), "S"(0), "D"(tid),
+		  [nr_exit]"i"(__NR_exit)
+		: "memory", "cc"
+	);
+	return _ret;
+#elif defined(__aarch64__)
+	sp -= 2;
+	sp[0] = (long)fn;
+	sp[1] = (long)arg;
+	register long _num  __asm__ ("x8") = __NR_clone;
+	register long _arg1 __asm__ ("x0") = CLONE_THREAD_FLAGS;
+	register long _arg2 __asm__ ("x1") = (long)sp;
+	register long _arg3 __asm__ ("x2") = (long)tid;
+	register long _arg4 __asm__ ("x3") = 0;
+	register long _arg5 __asm__ ("x4") = (long)tid;
+
+	/* clone(flags, newsp, ptid, tls, ctid) */
+	__asm__ volatile (
+		"svc  #0\n"
+		"cbnz x0, 1f\n"
+		"ldp  x1, x0, [sp], #16\n" /* fn, arg                            */
+		"mov  x29, xzr\n"          /* zero the stack frame               */
+		"mov  x30, xzr\n"
+		"blr  x1\n"
+		"mov  x0, xzr\n"
+		"mov  x8, %[nr_exit]\n"
+		"svc  #0\n"
+		"1:\n"
+		: "=r"(_arg1)
+		: "r"(_arg1), "r"(_arg2), "r"(_arg3), "r"(_arg4), "r"(_arg5),
+		  "r"(_num), [nr_exit]"i"(__NR_exit)
+		: "memory", "cc"
+	);
+	return _arg1;
+#elif defined(__riscv)
+#if __riscv_xlen == 64
+#define CLONE_REG_L "ld"
+#define CLONE_SZREG "8"
+#else
+#define CLONE_REG_L "lw"
+#define CLONE_SZREG "4"
+#endif
+	sp = (long *)(stack_top - 16);
+	sp[0] = (long)fn;
+	sp[1] = (long)arg;
+	register long _num  __asm__ ("a7") = __NR_clone;
+	register long _arg1 __asm__ ("a0") = CLONE_THREAD_FLAGS;
+	register long _arg2 __asm__ ("a1") = (long)sp;
+	register long _arg3 __asm__ ("a2") = (long)tid;
+	register long _arg4 __asm__ ("a3") = 0;
+	register long _arg5 __asm__ ("a4") = (long)tid;
+
+	/* clone(flags, newsp, ptid, tls, ctid) */
+	__asm__ volatile (
+		"ecall\n"
+		"bnez a0, 1f\n"
+		CLONE_REG_L " a1, 0(sp)\n"            /* fn                      */
+		CLONE_REG_L " a0, " CLONE_SZREG "(sp)\n" /* arg                  */
+		"addi sp, sp, 16\n"
+		"mv   s0, zero\n"                     /* zero the stack frame    */
+		"mv   ra, zero\n"
+		"jalr a1\n"
+		"li   a0, 0\n"
+		"li   a7, %[nr_exit]\n"
+		"ecall\n"
+		"1:\n"
+		: "+r"(_arg1)
+		: "r"(_arg2), "r"(_arg3), "r"(_arg4), "r"(_arg5),
+		  "r"(_num), [nr_exit]"i"(__NR_exit)
+		: "memory", "cc"
+	);
+	return _arg1;
+#elif defined(__loongarch__)
+	sp -= 2;
+	sp[0] = (long)fn;
+	sp[1] = (long)arg;
+	register long _num  __asm__ ("a7") = __NR_clone;
+	register long _arg1 __asm__ ("a0") = CLONE_THREAD_FLAGS;
+	register long _arg2 __asm__ ("a1") = (long)sp;
+	register long _arg3 __asm__ ("a2") = (long)tid;
+	register long _arg4 __asm__ ("a3") = 0;
+	register long _arg5 __asm__ ("a4") = (long)tid;
+
+	/* clone(flags, newsp, ptid, tls, ctid) */
+	__asm__ volatile (
+		"syscall 0\n"
+		"bnez    $a0, 1f\n"
+		"ld.d    $a1, $sp, 0\n"   /* fn                                  */
+		"ld.d    $a0, $sp, 8\n"   /* arg                                 */
+		"addi.d  $sp, $sp, 16\n"
+		"move    $fp, $zero\n"    /* zero the stack frame                */
+		"move    $ra, $zero\n"
+		"jirl    $ra, $a1, 0\n"
+		"move    $a0, $zero\n"
+		"li.w    $a7, %[nr_exit]\n"
+		"syscall 0\n"
+		"1:\n"
+		: "+r"(_arg1)
+		: "r"(_arg2), "r"(_arg3), "r"(_arg4), "r"(_arg5),
+		  "r"(_num), [nr_exit]"i"(__NR_exit)
+		: _NOLIBC_SYSCALL_CLOBBERLIST
+	);
+	return _arg1;
+#else
+#error "clone threads not supported on this architecture"
+#endif
 }
+
+/* Function: core_start_parallel
+        Start benchmarking in a parallel context.
+
+        Each context runs <iterate> on its own static stack, in a thread created
+   with the raw clone syscall.
+*/
+ee_u8
+core_start_parallel(core_results *res)
+{
+	long ret;
+
+	if (clone_active >= MULTITHREAD)
+		return 1;
+#if NUMA_PLACE
+	res->port.ctx = clone_active;
+#endif
+#if USE_PERF
+	if (perf_threads >= MULTITHREAD)
+		return 1;
+	perf_context_slot[perf_threads].res = res;
+	ret = clone_thread(perf_context, &perf_context_slot[perf_threads],
+			   clone_stack[clone_active] + CLONE_STACK_SIZE,
+			   &res->port.tid);
+	if (ret >= 0)
+		perf_threads++;
+#else
+	ret = clone_thread(PARALLEL_ENTRY, res,
+			   clone_stack[clone_active] + CLONE_STACK_SIZE,
+			   &res->port.tid);
+#endif
+	if (ret < 0) {
+		ee_printf("ERROR in clone: %d\n", (int)ret);
+		return 1;
+	}
+	clone_active++;
+	return 0;
+}
+
+/* Function: core_stop_parallel
+        Wait for a parallel context to exit.
+
+        The kernel clears the thread id and wakes us through the futex once the
+   thread is gone, so its stack can be reused by the next start.
+*/
+ee_u8
+core_stop_parallel(core_results *res)
+{
+	int tid;
+
+	while ((tid = res->port.tid) != 0)
+		my_syscall4(__NR_futex, &res->port.tid, FUTEX_WAIT, tid, NULL);
+	clone_active--;
+	return 0;
+}
+#endif
@@ -0,0 +1,22 @@
+/*
+Copyright 2018 Embedded Microprocessor Benchmark Consortium (EEMBC)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/* Topic: Description
+        Timing, seeds, init and parallel contexts are those of the posix
+   port. The C library calls they make (clock_gettime, malloc, syscall, the
+   clone threads) are provided by <minic.c>, linked in by core_portme.mak.
+*/
+#include "../posix/core_portme.c"
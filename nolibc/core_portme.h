@@ -0,0 +1,52 @@
+/*
+Copyright 2018 Embedded Microprocessor Benchmark Consortium (EEMBC)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/* Topic: Description
+        Port for the static nolibc/nofp images. This is the posix port, with
+   the nolibc runtime in <minic.c> in place of the C library: no floating
+   point, ee_printf from the runtime, static data blocks and raw clone
+   threads. Only the defaults differ, every posix configuration flag can
+   still be set on the command line.
+*/
+#ifndef NOLIBC_CORE_PORTME_H
+#define NOLIBC_CORE_PORTME_H
+
+#ifndef HAS_FLOAT
+#define HAS_FLOAT 0
+#endif
+#ifndef HAS_PRINTF
+#define HAS_PRINTF 0
+#endif
+#ifndef MEM_METHOD
+#define MEM_METHOD MEM_STATIC
+#endif
+/* nanosecond ticks, microseconds where CORE_TICKS (clock_t) is 32b */
+#ifndef TIMER_RES_DIVIDER
+#if (__SIZEOF_LONG__ == 4)
+#define TIMER_RES_DIVIDER 1000
+#else
+#define TIMER_RES_DIVIDER 1
+#endif
+#endif
+/* the runtime has neither pthreads nor fork */
+#if defined(MULTITHREAD) && (MULTITHREAD > 1) && !defined(USE_PTHREAD) \
+    && !defined(USE_FORK) && !defined(USE_SOCKET) && !defined(USE_CLONE)
+#define USE_CLONE 1
+#endif
+
+#include "../posix/core_portme.h"
+
+#endif /* NOLIBC_CORE_PORTME_H */
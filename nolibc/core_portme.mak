@@ -0,0 +1,217 @@
+# Copyright 2018 Embedded Microprocessor Benchmark Consortium (EEMBC)
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#    http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+#File: core_portme.mak
+
+# Static nolibc/nofp images, one object directory per target architecture.
+#
+#   make PORT_DIR=nolibc                     native build, run1.log/run2.log
+#   make PORT_DIR=nolibc ARCH=aarch64        cross build, run under qemu-user
+#   make PORT_DIR=nolibc -j5 all-arches      every arch with a cross compiler
+#   make PORT_DIR=nolibc PGO=1 LTO=1         profile optimized image
+
+# Flag: ARCH
+#	Target architecture, one of NOLIBC_ARCHES. The compiler is
+#	$(ARCH)-linux-gnu-gcc unless CC is given.
+HOST_ARCH := $(shell uname -m)
+ARCH ?= $(HOST_ARCH)
+NOLIBC_ARCHES ?= i686 x86_64 aarch64 riscv64 loongarch64
+
+# Flag: OPATH
+# Path to the output folder, one per arch.
+OPATH = build/nolibc/$(ARCH)/
+# Flag: MKDIR
+# Command to create the output folders.
+MKDIR = mkdir -p
+
+# Flag: OUTFLAG
+#	Use this flag to define how to to get an executable (e.g -o)
+OUTFLAG= -o
+# Flag: CC
+#	Use this flag to define compiler to use
+ifeq ($(origin CC),default)
+CC = $(ARCH)-linux-gnu-gcc
+endif
+# Flag: CFLAGS
+#	Use this flag to define compiler options. Note, you can add compiler
+#	options from the command line using XCFLAGS="other flags"
+PORT_CFLAGS = -O2 -fno-pie
+ifeq ($(ARCH),i686)
+PORT_CFLAGS += -mgeneral-regs-only
+ARCH_LFLAGS = -T vmlinux.lds
+endif
+ifeq ($(ARCH),x86_64)
+PORT_CFLAGS += -mgeneral-regs-only
+ARCH_LFLAGS = -T vmlinux.lds
+endif
+ifeq ($(ARCH),aarch64)
+PORT_CFLAGS += -mgeneral-regs-only
+ARCH_LFLAGS = -T vmlinux.lds
+endif
+# Flag: LTO
+#	LTO=1 compiles and links with -flto.
+ifdef LTO
+PORT_CFLAGS += -flto
+endif
+# Flag: PGO
+#	PGO=1 compiles with -fprofile-use, after a profile generation stage
+#	(see port_prebuild). PGO=gen is that stage: instrumented objects, and
+#	the runtime writes the .gcda files next to them at exit (GCOV_DUMP).
+ifdef PGO
+ ifeq (,$(findstring $(PGO),gen))
+  PGO_STAGE = build_pgo_gcc
+  PORT_CFLAGS += -fprofile-use
+ else
+  PORT_CFLAGS += -fprofile-generate -fno-profile-values \
+	-fprofile-info-section=gcov_info -DGCOV_DUMP=1
+  LFLAGS_END += -lgcov
+ endif
+endif
+FLAGS_STR = "$(PORT_CFLAGS) $(XCFLAGS) $(XLFLAGS) $(LFLAGS_END)"
+CFLAGS = $(PORT_CFLAGS) -I$(PORT_DIR) -Iposix -I. -DFLAGS_STR=\"$(FLAGS_STR)\" \
+	-MMD -MP
+# Flag: LFLAGS_END
+#	Define any libraries needed for linking or other flags that should come at the end of the link line (e.g. linker scripts).
+LFLAGS_END +=
+# Flag: PORT_SRCS
+#	Port specific source files can be added here. The runtime takes the
+#	place of the C library.
+PORT_SRCS = $(PORT_DIR)/core_portme.c minic.c
+vpath %.c posix
+vpath %.h posix
+vpath %.mak posix
+# the image is out of date when an object is, which tracks headers and flags.
+# With PGO=1 the objects are compiled after the profile run only, and the
+# image follows the sources and the flags.
+ifdef PGO_STAGE
+EXTRA_DEPENDS += $(PORT_DIR)/core_portme.mak $(OPATH)flags
+else
+EXTRA_DEPENDS += $(PORT_DIR)/core_portme.mak $(OBJS)
+endif
+
+# Flag: LOAD
+#	For a simple port, we assume self hosted compile and run, no load needed.
+LOAD = echo Loading done
+
+# Flag: RUN
+#	Native images run directly (i686 too on an x86_64 host), the others
+#	under qemu-user. Set RUN to override, e.g. RUN="qemu-aarch64 -cpu max".
+QEMU_i686        = qemu-i386
+QEMU_x86_64      = qemu-x86_64
+QEMU_aarch64     = qemu-aarch64
+QEMU_riscv64     = qemu-riscv64
+QEMU_loongarch64 = qemu-loongarch64
+ifeq ($(ARCH),$(HOST_ARCH))
+RUN ?=
+else ifeq ($(ARCH)-$(HOST_ARCH),i686-x86_64)
+RUN ?=
+else
+RUN ?= $(QEMU_$(ARCH))
+endif
+
+OEXT = .o
+EXE = _nolibc_nofp_$(ARCH).exe
+
+# Objects are always compiled separately, into the object directory of
+# the arch, so that only what changed is rebuilt.
+SEPARATE_COMPILE = 1
+LD		= $(CC)
+OBJOUT 	= -o
+LFLAGS 	= -static -nostdlib -fno-pie -Wl,--build-id=none \
+	-Wl,-z,max-page-size=65536 $(ARCH_LFLAGS)
+# code generation happens at link time with LTO
+ifdef LTO
+LFLAGS += $(PORT_CFLAGS)
+endif
+OFLAG 	= -o
+COUT 	= -c
+PORT_OBJS = $(PORT_DIR)/core_portme$(OEXT) minic$(OEXT)
+PORT_CLEAN = $(OPATH)*.d $(OPATH)$(PORT_DIR)/*.d $(OPATH)flags \
+	$(OPATH)*.gcda $(OPATH)$(PORT_DIR)/*.gcda
+
+# The objects also depend on the compiler and flags they were built with,
+# recorded in $(OPATH)flags, which is only rewritten when they change. The
+# run type defines added by rerun do not matter with seeds from argv.
+BUILD_FLAGS = $(CC) $(PORT_CFLAGS) -DITERATIONS=$(ITERATIONS) \
+	$(filter-out -DPERFORMANCE_RUN=1 -DVALIDATION_RUN=1,$(XCFLAGS))
+.PHONY: build_flags
+build_flags:
+$(OPATH)flags: build_flags | $(OPATH)
+	@echo '$(BUILD_FLAGS)' | cmp -s - $@ || echo '$(BUILD_FLAGS)' > $@
+
+# The vector kernels of MATRIX_SIMD need the SIMD registers that the rest
+# of the image does without. Their object is kept out of LTO, whose code
+# generation would take the -mgeneral-regs-only of the link.
+ifneq (,$(findstring -DMATRIX_SIMD=1,$(XCFLAGS)))
+$(OPATH)core_matrix$(OEXT): PORT_CFLAGS := \
+	$(filter-out -mgeneral-regs-only -flto,$(PORT_CFLAGS))
+endif
+$(OPATH)%$(OEXT) : %.c $(OPATH)flags | $(OPATH)
+	$(CC) $(CFLAGS) $(XCFLAGS) $(COUT) $< $(OBJOUT) $@
+
+$(OPATH)$(PORT_DIR)/%$(OEXT) : $(PORT_DIR)/%.c $(OPATH)flags | $(OPATH)$(PORT_DIR)
+	$(CC) $(CFLAGS) $(XCFLAGS) $(COUT) $< $(OBJOUT) $@
+
+-include $(wildcard $(OPATH)*.d $(OPATH)$(PORT_DIR)/*.d)
+
+# Target: all-arches
+#	Build and run every arch of NOLIBC_ARCHES, in parallel with -j. An arch
+#	without a cross compiler is skipped, and is only built when its qemu
+#	is missing. NOLIBC_GOAL picks the target made for each arch.
+NOLIBC_GOAL ?= run
+.PHONY: all-arches
+all-arches: $(addprefix arch-,$(NOLIBC_ARCHES))
+
+.PHONY: $(addprefix arch-,$(NOLIBC_ARCHES))
+$(addprefix arch-,$(NOLIBC_ARCHES)): arch-% :
+	@if ! command -v $*-linux-gnu-gcc > /dev/null; then \
+		echo "$*-linux-gnu-gcc does not exist, skip $*"; \
+	elif [ "$(NOLIBC_GOAL)" = run ] && [ "$*" != "$(HOST_ARCH)" ] \
+		&& [ "$*-$(HOST_ARCH)" != "i686-x86_64" ] \
+		&& ! command -v $(QEMU_$*) > /dev/null; then \
+		echo "$(QEMU_$*) does not exist, build $* only"; \
+		$(MAKE) PORT_DIR=$(PORT_DIR) ARCH=$* CC=$*-linux-gnu-gcc link; \
+	else \
+		$(MAKE) PORT_DIR=$(PORT_DIR) ARCH=$* CC=$*-linux-gnu-gcc $(NOLIBC_GOAL); \
+	fi
+
+# Target: port_prebuild
+# With PGO=1, build the instrumented image in the same object directory and
+# run it with the profile generation parameters (run3.log), as the posix
+# port does. The use build then finds each .gcda next to its object.
+.PHONY: port_prebuild
+port_prebuild: $(PGO_STAGE)
+
+.PHONY: build_pgo_gcc
+build_pgo_gcc:
+	rm -f $(OPATH)*.gcda $(OPATH)$(PORT_DIR)/*.gcda
+	$(MAKE) PGO=gen XCFLAGS="$(XCFLAGS) -DTOTAL_DATA_SIZE=1200" ITERATIONS=10 gen_pgo_data REBUILD=1
+
+# Target: port_post%
+# For the nolibc port, no extra steps are needed.
+
+.PHONY: port_postbuild
+port_postbuild:
+
+.PHONY: port_postrun
+port_postrun:
+
+.PHONY: port_prerun
+port_prerun:
+
+.PHONY: port_postload
+port_postload:
+
+.PHONY: port_preload
+port_preload:
@@ -19,11 +19,48 @@ Original Author: Shay Gal-on
 #include <stdio.h>
 #include <stdlib.h>
 #include "coremark.h"
-#if CALLGRIND_RUN
-#include <valgrind/callgrind.h>
+
+#if (MULTITHREAD > 1) && NUMA_PLACE
+#ifndef PLACE_PAGE_SIZE
+#define PLACE_PAGE_SIZE 4096
+#endif
 #endif
 
-#if (MEM_METHOD == MEM_MALLOC)
+#if (MEM_METHOD == MEM_MALLOC) || SIZE_SWEEP || LIST_CHASE
+#if (MULTITHREAD > 1) && NUMA_PLACE
+/* Function: portable_malloc
+        Provide malloc() functionality in a platform specific way.
+
+        With NUMA_PLACE each block starts on a page and is padded to whole
+   pages, so that binding the block of a context to its node (see
+   <portable_context>) moves no data of another context. The pointer from
+   malloc is kept in the word before the block, for <portable_free>.
+*/
+void *
+portable_malloc(size_t size)
+{
+    size_t     pages = (size + PLACE_PAGE_SIZE - 1)
+                   & ~(size_t)(PLACE_PAGE_SIZE - 1);
+    void      *p     = malloc(pages + PLACE_PAGE_SIZE);
+    ee_ptr_int block;
+
+    if (p == NULL)
+        return NULL;
+    block = ((ee_ptr_int)p + sizeof(void *) + PLACE_PAGE_SIZE - 1)
+            & ~(ee_ptr_int)(PLACE_PAGE_SIZE - 1);
+    ((void **)block)[-1] = p;
+    return (void *)block;
+}
+/* Function: portable_free
+        Provide free() functionality in a platform specific way.
+*/
+void
+portable_free(void *p)
+{
+    if (p)
+        free(((void **)p)[-1]);
+}
+#else
 /* Function: portable_malloc
         Provide malloc() functionality in a platform specific way.
 */
@@ -40,6 +77,7 @@ portable_free(void *p)
 {
     free(p);
 }
+#endif
 #else
 void *
 portable_malloc(size_t size)
@@ -139,13 +177,11 @@ static CORETIMETYPE start_time_val, stop_time_val;
 void
 start_time(void)
 {
-    GETMYTIME(&start_time_val);
-#if CALLGRIND_RUN
-    CALLGRIND_START_INSTRUMENTATION
-#endif
-#if MICA
-    asm volatile("int3"); /*1 */
+#if USE_PERF
+    perf_counters_start();
 #endif
+    GETMYTIME(&start_time_val);
+    ROI_BEGIN();
 }
 /* Function: stop_time
         This function will be called right after ending the timed portion of the
@@ -158,13 +194,11 @@ start_time(void)
 void
 stop_time(void)
 {
-#if CALLGRIND_RUN
-    CALLGRIND_STOP_INSTRUMENTATION
-#endif
-#if MICA
-    asm volatile("int3"); /*1 */
-#endif
+    ROI_END();
     GETMYTIME(&stop_time_val);
+#if USE_PERF
+    perf_counters_stop();
+#endif
 }
 /* Function: get_time
         Return an abstract "ticks" number that signifies time on the system.
@@ -195,12 +229,201 @@ time_in_secs(CORE_TICKS ticks)
     secs_ret retval = ((secs_ret)ticks) / (secs_ret)EE_TICKS_PER_SEC;
     return retval;
 }
+#if MATRIX_SIMD || STATE_SIMD || LIST_CHASE || SCALE_SWEEP || TRIALS
+/* Function: portable_start_clock
+        As <start_time>, but only reads the timer: no perf counters, no ROI
+   marker. Used to time the passes besides the reported run.
+*/
+void
+portable_start_clock(void)
+{
+    GETMYTIME(&start_time_val);
+}
+/* Function: portable_stop_clock
+        As <stop_time>, but only reads the timer. <get_time> then returns the
+   ticks since <portable_start_clock>.
+*/
+void
+portable_stop_clock(void)
+{
+    GETMYTIME(&stop_time_val);
+}
+#endif
+#if KERNEL_TIMING || SCALE_SWEEP
+/* Function: portable_ticks
+        Return the ticks elapsed since <start_time>, in the same unit as
+   <get_time>. Used to account time to the individual kernels, and to time
+   the end of each context in the scaling sweep.
+*/
+CORE_TICKS
+portable_ticks(void)
+{
+    CORETIMETYPE now;
+    GETMYTIME(&now);
+    return (CORE_TICKS)(MYTIMEDIFF(now, start_time_val));
+}
+#endif
 #else
 #error "Please implement timing functionality in core_portme.c"
 #endif /* SAMPLE_TIME_IMPLEMENTATION */
 
 ee_u32 default_num_contexts = MULTITHREAD;
 
+#if (MULTITHREAD > 1) && NUMA_PLACE
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define MPOL_BIND    2
+#define MPOL_MF_MOVE (1 << 1)
+#define PLACE_WORD_BITS  (8 * sizeof(unsigned long))
+#define PLACE_WORDS(n)   (((n) + PLACE_WORD_BITS - 1) / PLACE_WORD_BITS)
+
+/* CPUs the process may run on, read once before any context starts */
+static unsigned long place_cpus[PLACE_WORDS(NUMA_MAX_CPUS)];
+static ee_u32        place_ncpus;
+/* where each context ended up, filled in by the context itself */
+static struct
+{
+    int    cpu;
+    int    node;
+    ee_u32 bound; /* bytes bound to the node, 0 if mbind failed */
+    ee_u8  placed;
+} place_map[MULTITHREAD];
+
+/* Function: place_init
+        Read the affinity mask of the process. The system calls are made
+   directly (through the runtime syscall entry) so the same code serves the
+   libc and the nolibc builds.
+*/
+static void
+place_init(void)
+{
+    long   ret;
+    ee_u32 i;
+
+    ret = syscall(SYS_sched_getaffinity, 0, sizeof(place_cpus), place_cpus);
+    place_ncpus = 0;
+    if (ret <= 0)
+        return;
+    for (i = 0; i < NUMA_MAX_CPUS; i++)
+        if (place_cpus[i / PLACE_WORD_BITS] & (1UL << (i % PLACE_WORD_BITS)))
+            place_ncpus++;
+}
+
+/* Function: portable_context
+        Entry of a parallel context. Pin the calling thread to its CPU, ask the
+   kernel which node that is, and bind (moving the pages already touched by
+   the init in main) the data block of the context to that node. The binding
+   is only done on the first run of a context, later runs just pin.
+*/
+void *
+portable_context(void *pres)
+{
+    core_results *res = (core_results *)pres;
+    ee_u16        ctx = res->port.ctx;
+    unsigned long mask[PLACE_WORDS(NUMA_MAX_CPUS)];
+    unsigned long nodes[PLACE_WORDS(NUMA_MAX_NODES)];
+    unsigned      cpu, node;
+    ee_u32        i, n;
+    ee_ptr_int    start, end;
+
+    if (place_ncpus == 0)
+        return iterate(pres);
+    n = ctx % place_ncpus;
+    for (i = 0; i < NUMA_MAX_CPUS; i++)
+        if ((place_cpus[i / PLACE_WORD_BITS] & (1UL << (i % PLACE_WORD_BITS)))
+            && (n-- == 0))
+            break;
+    memset(mask, 0, sizeof(mask));
+    mask[i / PLACE_WORD_BITS] = 1UL << (i % PLACE_WORD_BITS);
+    syscall(SYS_sched_setaffinity, 0, sizeof(mask), mask);
+    if (place_map[ctx].placed)
+        return iterate(pres);
+
+    cpu = i;
+    node = 0;
+    syscall(SYS_getcpu, &cpu, &node, NULL);
+    place_map[ctx].cpu  = cpu;
+    place_map[ctx].node = node;
+    if (node < NUMA_MAX_NODES)
+    {
+        memset(nodes, 0, sizeof(nodes));
+        nodes[node / PLACE_WORD_BITS] = 1UL << (node % PLACE_WORD_BITS);
+        for (i = 0; i < 2; i++)
+        {
+            if (res->port.place_size[i] == 0)
+                continue;
+            start = (ee_ptr_int)res->port.place_block[i]
+                    & ~(ee_ptr_int)(PLACE_PAGE_SIZE - 1);
+            end = ((ee_ptr_int)res->port.place_block[i]
+                   + res->port.place_size[i] + PLACE_PAGE_SIZE - 1)
+                  & ~(ee_ptr_int)(PLACE_PAGE_SIZE - 1);
+            /* maxnode counts one past the last bit the kernel reads */
+            if (syscall(SYS_mbind, start, end - start, MPOL_BIND, nodes,
+                        8 * sizeof(nodes) + 1, MPOL_MF_MOVE)
+                == 0)
+                place_map[ctx].bound += end - start;
+        }
+    }
+    place_map[ctx].placed = 1;
+    return iterate(pres);
+}
+
+/* Function: place_report
+        Print the context to CPU to node map.
+*/
+static void
+place_report(void)
+{
+    ee_u32 i;
+
+    if (place_ncpus == 0)
+    {
+        ee_printf("Placement        : sched_getaffinity failed, not pinned\n");
+        return;
+    }
+    for (i = 0; i < default_num_contexts; i++)
+    {
+        if (!place_map[i].placed)
+            continue;
+        if (place_map[i].bound)
+            ee_printf("Context %-8d : cpu %d, node %d, %d KiB bound\n",
+                      (int)i,
+                      place_map[i].cpu,
+                      place_map[i].node,
+                      (int)(place_map[i].bound >> 10));
+        else
+            ee_printf("Context %-8d : cpu %d, node %d, first touch\n",
+                      (int)i,
+                      place_map[i].cpu,
+                      place_map[i].node);
+    }
+}
+#endif
+
+#if KERNEL_TIMING || SIMPOINT
+/* Function: portable_cycles
+        Return a free running cycle counter, or 0 if there is none.
+        Runtimes that can read the hardware counters (e.g. minic.c) override
+   this and <portable_instret>.
+*/
+__attribute__((weak)) unsigned long
+portable_cycles(void)
+{
+    return 0;
+}
+/* Function: portable_instret
+        Return a free running retired instructions counter, or 0 if there is
+   none.
+*/
+__attribute__((weak)) unsigned long
+portable_instret(void)
+{
+    return 0;
+}
+#endif
+
 /* Function: portable_init
         Target specific initialization code
         Test for some common mistakes.
@@ -250,6 +473,9 @@ portable_init(core_portable *p, int *argc, char *argv[])
     }
 #endif /* sample of potential platform specific init via command line, reset \
           the number of contexts being used if first argument is M<n>*/
+#if (MULTITHREAD > 1) && NUMA_PLACE
+    place_init();
+#endif
     p->portable_id = 1;
 }
 /* Function: portable_fini
@@ -258,6 +484,12 @@ portable_init(core_portable *p, int *argc, char *argv[])
 void
 portable_fini(core_portable *p)
 {
+#if (MULTITHREAD > 1) && NUMA_PLACE
+    place_report();
+#endif
+#if USE_PERF
+    perf_counters_report();
+#endif
     p->portable_id = 0;
 }
 
@@ -278,16 +510,25 @@ portable_fini(core_portable *p)
    MCAPI or other standards can easily be devised.
 */
 #if USE_PTHREAD
+#if NUMA_PLACE
+static ee_u16 parallel_active = 0;
+#endif
 ee_u8
 core_start_parallel(core_results *res)
 {
+#if NUMA_PLACE
+    res->port.ctx = parallel_active++;
+#endif
     return (ee_u8)pthread_create(
-        &(res->port.thread), NULL, iterate, (void *)res);
+        &(res->port.thread), NULL, PARALLEL_ENTRY, (void *)res);
 }
 ee_u8
 core_stop_parallel(core_results *res)
 {
     void *retval;
+#if NUMA_PLACE
+    parallel_active--;
+#endif
     return (ee_u8)pthread_join(res->port.thread, &retval);
 }
 #elif USE_FORK
@@ -416,6 +657,8 @@ core_stop_parallel(core_results *res)
     }
     return 1;
 }
+#elif USE_CLONE
+/* core_start_parallel and core_stop_parallel are provided by minic.c */
 #else /* no standard multicore implementation */
 #error \
     "Please implement multicore functionality in core_portme.c to use multiple contexts."
@@ -214,6 +214,172 @@ typedef size_t         ee_size_t;
 #define USE_SOCKET 0
 #endif
 
+/* Configuration: USE_CLONE
+        Sample implementation for launching parallel contexts without libc.
+        This implementation uses raw clone and futex system calls, and is
+   provided by the nolibc runtime in <minic.c>.
+
+        Valid values:
+        0 - Do not use clone API.
+        1 - Use clone API
+
+        Note:
+        This flag only matters if MULTITHREAD has been defined to a value
+   greater then 1.
+*/
+#ifndef USE_CLONE
+#define USE_CLONE 0
+#endif
+
+/* Configuration: USE_PERF
+        Count hardware events (cycles, instructions, branch, L1D, LLC and dTLB
+   misses) around the timed region with perf_event_open, and report IPC, CPI
+   and MPKI at the end of the run. Implemented by the nolibc runtime in
+   <minic.c> with raw system calls. Each clone context counts its own
+   thread and the counts are added after the join; events the kernel
+   multiplexed are scaled to the time they were enabled. Only the reported
+   run is counted, the median trial with <TRIALS>; the passes timed after it
+   use <portable_start_clock>.
+
+        Valid values:
+        0 - Do not count hardware events.
+        1 - Count hardware events.
+*/
+#ifndef USE_PERF
+#define USE_PERF 0
+#endif
+
+/* Configuration: USE_HUGEPAGES
+        Back the blocks from <portable_malloc> with 2 MiB pages, hugetlb
+   pages when a pool is reserved and transparent huge pages otherwise, and
+   prefault them at allocation. Implemented by the nolibc runtime in <minic.c>,
+   only matters with MEM_METHOD set to MEM_MALLOC or with SIZE_SWEEP.
+
+        Valid values:
+        0 - Use 4 KiB pages, faulted in on first use.
+        1 - Use prefaulted 2 MiB pages.
+*/
+#ifndef USE_HUGEPAGES
+#define USE_HUGEPAGES 0
+#endif
+
+/* Configuration: PRINT_BUFFER
+        Output path of ee_printf in the nolibc runtime (<minic.c>). Buffered
+   output collects the report in a ring of PRINT_BUFFER_SIZE bytes and writes
+   it with a single writev at exit, or earlier when the ring would overflow.
+   The memory mode never writes: the last PRINT_BUFFER_SIZE bytes of output
+   stay in ee_print_ring, and ee_print_head counts all bytes printed, for a
+   debugger or simulator to dump.
+
+        Valid values:
+        PRINT_DIRECT - one write system call per ee_printf (default).
+        PRINT_BATCH - buffer, flush at exit or when full.
+        PRINT_MEMORY - buffer only, no system calls.
+*/
+#define PRINT_DIRECT 0
+#define PRINT_BATCH  1
+#define PRINT_MEMORY 2
+
+#ifndef PRINT_BUFFER
+#define PRINT_BUFFER PRINT_DIRECT
+#endif
+#ifndef PRINT_BUFFER_SIZE
+#define PRINT_BUFFER_SIZE 16384
+#endif
+
+/* Configuration: GCOV_DUMP
+        Profile dump of the nolibc runtime (<minic.c>), for the profile
+   generation build of PGO. The objects are built with -fprofile-generate
+   -fprofile-info-section=gcov_info -fno-profile-values, which keeps the
+   counters in a table instead of registering them with the libgcov
+   runtime, and at exit the runtime writes each .gcda file with raw system
+   calls. Only __gcov_info_to_gcda is taken from libgcov (GCC 12 or later),
+   it needs no C library.
+
+        Valid values:
+        0 - no profile dump (default).
+        1 - write the .gcda files at exit.
+*/
+#ifndef GCOV_DUMP
+#define GCOV_DUMP 0
+#endif
+
+/* Configuration: ROI_MARKERS
+        Markers issued at the start and end of the timed region, so that a
+   simulator can fast forward to it, or a tool instrument only it. See
+   <core_roi.h>.
+
+        Valid values:
+        ROI_NONE - no markers (default).
+        ROI_GEM5 - gem5 m5ops: reset stats at the start, dump at the end.
+        ROI_QEMU - no-op magic instructions for a QEMU TCG plugin.
+        ROI_VALGRIND - callgrind instrumentation on and off (CALLGRIND_RUN).
+        ROI_MICA - int3 breakpoints for MICA (MICA).
+        ROI_DEBUGCON - event characters written to the QEMU debug console at
+   DEBUGCON_PORT: an I/O port on x86 (0xe9, -debugcon), a MMIO address on
+   LoongArch64. Only for images that run bare-metal with DEBUGCON, a Linux
+   process has no access to either.
+*/
+#define ROI_NONE     0
+#define ROI_GEM5     1
+#define ROI_QEMU     2
+#define ROI_VALGRIND 3
+#define ROI_MICA     4
+#define ROI_DEBUGCON 5
+
+#ifndef ROI_MARKERS
+#if CALLGRIND_RUN
+#define ROI_MARKERS ROI_VALGRIND
+#elif MICA
+#define ROI_MARKERS ROI_MICA
+#else
+#define ROI_MARKERS ROI_NONE
+#endif
+#endif
+#ifndef DEBUGCON_PORT
+#if defined(__x86_64__) || defined(__i386__)
+#define DEBUGCON_PORT 0xe9
+#else
+#define DEBUGCON_PORT 0x800000001fe002e0ull
+#endif
+#endif
+
+/* Configuration: ROI_ITERATIONS
+        Define to 1 to also mark the start and end of each iteration of
+   <iterate> (gem5 work items, a callgrind dump per iteration), for per
+   iteration checkpoints and statistics. The markers are part of the timed
+   region.
+*/
+#ifndef ROI_ITERATIONS
+#define ROI_ITERATIONS 0
+#endif
+
+/* Configuration: NUMA_PLACE
+        Pin parallel context i to the i-th CPU the process may run on (round
+   robin), bind its data block to the memory node of that CPU with mbind, and
+   print the context to CPU to node map at the end of the run. Blocks from
+   <portable_malloc> are page aligned and padded, so that no two contexts
+   share a page. Done from inside each context with raw system calls, so it
+   works with the nolibc runtime in <minic.c> as well.
+
+        Valid values:
+        0 - Leave placement to the scheduler and first touch.
+        1 - Pin contexts and bind their data to the local node.
+
+        Note:
+        This flag only matters if MULTITHREAD has been defined to a value
+   greater then 1, and is supported with USE_PTHREAD and USE_CLONE.
+*/
+#ifndef NUMA_PLACE
+#define NUMA_PLACE 0
+#endif
+#ifndef NUMA_MAX_CPUS
+#define NUMA_MAX_CPUS 1024
+#endif
+#ifndef NUMA_MAX_NODES
+#define NUMA_MAX_NODES 64
+#endif
+
 /* Configuration: MAIN_HAS_NOARGC
         Needed if platform does not support getting arguments to main.
 
@@ -272,11 +438,23 @@ extern ee_u32 default_num_contexts;
 #include <unistd.h>
 #include <errno.h>
 #define PARALLEL_METHOD "Sockets"
+#elif USE_CLONE
+#define PARALLEL_METHOD "Clone"
 #else
 #define PARALLEL_METHOD "Proprietary"
 #error \
     "Please implement multicore functionality in core_portme.c to use multiple contexts."
 #endif /* Method for multithreading */
+#if NUMA_PLACE
+#if !(USE_PTHREAD || USE_CLONE)
+#error "NUMA_PLACE needs USE_PTHREAD or USE_CLONE"
+#endif
+/* entry of a parallel context: place it, then run <iterate> */
+void *portable_context(void *pres);
+#define PARALLEL_ENTRY portable_context
+#else
+#define PARALLEL_ENTRY iterate
+#endif
 #endif /* MULTITHREAD > 1 */
 
 typedef struct CORE_PORTABLE_S
@@ -292,11 +470,39 @@ typedef struct CORE_PORTABLE_S
     pid_t              pid;
     int                sock;
     struct sockaddr_in sa;
+#elif USE_CLONE
+    volatile int tid;
 #endif /* Method for multithreading */
+#if NUMA_PLACE
+    ee_u16 ctx; /* index of the context, picks its CPU */
+    /* whole blocks of the context, bound to its node: data and matrix */
+    void * place_block[2];
+    ee_u32 place_size[2];
+#endif
 #endif /* MULTITHREAD>1 */
     ee_u8 portable_id;
 } core_portable;
 
+#if USE_PERF
+/* hardware events counted around the timed region */
+#define PERF_CYCLES        0
+#define PERF_INSTRUCTIONS  1
+#define PERF_BRANCH_MISSES 2
+#define PERF_L1D_MISSES    3
+#define PERF_LLC_MISSES    4
+#define PERF_DTLB_MISSES   5
+#define NUM_PERF_EVENTS    6
+
+void perf_counters_start(void);
+void perf_counters_stop(void);
+void perf_counters_report(void);
+int  perf_counter_read(int event, char *buf);
+#if TRIALS
+void perf_counters_save(int trial);
+void perf_counters_restore(int trial);
+#endif
+#endif
+
 /* target specific init/fini */
 void portable_init(core_portable *p, int *argc, char *argv[]);
 void portable_fini(core_portable *p);
@@ -313,4 +519,6 @@ void portable_fini(core_portable *p);
 #endif
 #endif /* SEED_METHOD==SEED_VOLATILE */
 
+#include "core_roi.h"
+
 #endif /* CORE_PORTME_H */
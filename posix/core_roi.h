@@ -0,0 +1,195 @@
+/*
+Copyright 2018 Embedded Microprocessor Benchmark Consortium (EEMBC)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/* Topic: Description
+        Region of interest markers for simulators and instrumentation tools,
+   selected with <ROI_MARKERS> in core_portme.h. <ROI_BEGIN> and <ROI_END> are
+   issued by start_time and stop_time around the timed region, and with
+   <ROI_ITERATIONS> <ROI_ITERATION_BEGIN> and <ROI_ITERATION_END> bracket each
+   iteration of <iterate>.
+
+        All markers expand to inline code (a magic instruction, a client
+   request or a debug console write) without system calls, so they work in
+   the nolibc build as well.
+*/
+#ifndef CORE_ROI_H
+#define CORE_ROI_H
+
+#if defined(DEBUGCON) || (ROI_MARKERS == ROI_DEBUGCON)
+/* one character on the QEMU debug console, shared with the DEBUGCON output
+ * of the nolibc runtime. Both need a bare-metal image: an I/O port write
+ * from a Linux process faults, and the MMIO address is not mapped. */
+#if (ROI_MARKERS == ROI_DEBUGCON) && !defined(DEBUGCON)
+#error "ROI_DEBUGCON needs a bare-metal image built with DEBUGCON"
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#define DEBUGCON_PUTC(c)                                              \
+    __asm__ volatile("outb %b0, %w1"                                  \
+                     :                                                \
+                     : "a"((char)(c)),                                \
+                       "Nd"((unsigned short)(DEBUGCON_PORT)))
+#elif defined(__loongarch__) && (__loongarch_grlen == 64)
+#define DEBUGCON_PUTC(c) (*(volatile char *)(DEBUGCON_PORT) = (c))
+#else
+#error "The debug console is available on x86 and LoongArch64"
+#endif
+#endif
+
+#if (ROI_MARKERS == ROI_GEM5)
+/* gem5 pseudo instructions (util/m5), first two arguments in the argument
+ * registers of the C ABI */
+#define M5OP_EXIT         0x21
+#define M5OP_RESET_STATS  0x40
+#define M5OP_DUMP_STATS   0x41
+#define M5OP_CHECKPOINT   0x43
+#define M5OP_WORK_BEGIN   0x5a
+#define M5OP_WORK_END     0x5b
+
+#if defined(__x86_64__)
+#define ROI_M5OP(func, a0, a1)                                        \
+    do                                                                \
+    {                                                                 \
+        unsigned long roi_a0 = (a0), roi_a1 = (a1);                   \
+        __asm__ volatile(".byte 0x0f, 0x04\n\t.word %c2"              \
+                         : "+D"(roi_a0), "+S"(roi_a1)                 \
+                         : "i"(func)                                  \
+                         : "rax", "memory");                          \
+    } while (0)
+#elif defined(__aarch64__)
+#define ROI_M5OP(func, a0, a1)                                        \
+    do                                                                \
+    {                                                                 \
+        register unsigned long roi_a0 __asm__("x0") = (a0);           \
+        register unsigned long roi_a1 __asm__("x1") = (a1);           \
+        __asm__ volatile(".inst 0xff000110 | (%c2 << 16)"             \
+                         : "+r"(roi_a0), "+r"(roi_a1)                 \
+                         : "i"(func)                                  \
+                         : "memory");                                 \
+    } while (0)
+#elif defined(__riscv)
+#define ROI_M5OP(func, a0, a1)                                        \
+    do                                                                \
+    {                                                                 \
+        register unsigned long roi_a0 __asm__("a0") = (a0);           \
+        register unsigned long roi_a1 __asm__("a1") = (a1);           \
+        __asm__ volatile(".long 0x0000007b | (%c2 << 25)"             \
+                         : "+r"(roi_a0), "+r"(roi_a1)                 \
+                         : "i"(func)                                  \
+                         : "memory");                                 \
+    } while (0)
+#else
+#error "ROI_GEM5 is available on x86_64, AArch64 and RISC-V"
+#endif
+
+/* statistics cover the timed region, each iteration is a work item so that
+ * gem5 can exit or checkpoint at a given one (--work-begin-checkpoint-count)
+ */
+#define ROI_BEGIN()            ROI_M5OP(M5OP_RESET_STATS, 0, 0)
+#define ROI_END()              ROI_M5OP(M5OP_DUMP_STATS, 0, 0)
+#define ROI_ITERATION_BEGIN(i) ROI_M5OP(M5OP_WORK_BEGIN, (i), 0)
+#define ROI_ITERATION_END(i)   ROI_M5OP(M5OP_WORK_END, (i), 0)
+
+#elif (ROI_MARKERS == ROI_QEMU)
+/* Markers for a QEMU TCG plugin: an instruction that executes as a no-op,
+ * with the event in the first argument register and the iteration in the
+ * second. The plugin matches the opcode and reads the two registers. */
+#define ROI_EVENT_BEGIN           1
+#define ROI_EVENT_END             2
+#define ROI_EVENT_ITERATION_BEGIN 3
+#define ROI_EVENT_ITERATION_END   4
+
+#if defined(__x86_64__) || defined(__i386__)
+#define ROI_MAGIC(event, arg)                                         \
+    __asm__ volatile("xchg %%bx, %%bx"                                \
+                     :                                                \
+                     : "D"((unsigned long)(event)),                   \
+                       "S"((unsigned long)(arg))                      \
+                     : "memory")
+#elif defined(__aarch64__)
+#define ROI_MAGIC(event, arg)                                         \
+    do                                                                \
+    {                                                                 \
+        register unsigned long roi_a0 __asm__("x0") = (event);        \
+        register unsigned long roi_a1 __asm__("x1") = (arg);          \
+        __asm__ volatile("orr xzr, xzr, xzr"                          \
+                         :                                            \
+                         : "r"(roi_a0), "r"(roi_a1)                   \
+                         : "memory");                                 \
+    } while (0)
+#elif defined(__riscv)
+#define ROI_MAGIC(event, arg)                                         \
+    do                                                                \
+    {                                                                 \
+        register unsigned long roi_a0 __asm__("a0") = (event);        \
+        register unsigned long roi_a1 __asm__("a1") = (arg);          \
+        __asm__ volatile("srai zero, zero, 31"                        \
+                         :                                            \
+                         : "r"(roi_a0), "r"(roi_a1)                   \
+                         : "memory");                                 \
+    } while (0)
+#else
+#error "ROI_QEMU is available on x86, AArch64 and RISC-V"
+#endif
+
+#define ROI_BEGIN()            ROI_MAGIC(ROI_EVENT_BEGIN, 0)
+#define ROI_END()              ROI_MAGIC(ROI_EVENT_END, 0)
+#define ROI_ITERATION_BEGIN(i) ROI_MAGIC(ROI_EVENT_ITERATION_BEGIN, (i))
+#define ROI_ITERATION_END(i)   ROI_MAGIC(ROI_EVENT_ITERATION_END, (i))
+
+#elif (ROI_MARKERS == ROI_VALGRIND)
+/* callgrind collects the timed region only, and dumps a profile per
+ * iteration */
+#include <valgrind/callgrind.h>
+#define ROI_BEGIN()            CALLGRIND_START_INSTRUMENTATION
+#define ROI_END()              CALLGRIND_STOP_INSTRUMENTATION
+#define ROI_ITERATION_BEGIN(i) ((void)(i))
+#define ROI_ITERATION_END(i)   CALLGRIND_DUMP_STATS_AT("iteration")
+
+#elif (ROI_MARKERS == ROI_MICA)
+/* MICA (Pin) starts and stops at a breakpoint trap */
+#if !(defined(__x86_64__) || defined(__i386__))
+#error "ROI_MICA is available on x86"
+#endif
+#define ROI_BEGIN()            __asm__ volatile("int3")
+#define ROI_END()              __asm__ volatile("int3")
+#define ROI_ITERATION_BEGIN(i) ((void)(i))
+#define ROI_ITERATION_END(i)   ((void)(i))
+
+#elif (ROI_MARKERS == ROI_DEBUGCON)
+/* one character on the debug console per event: '[' and ']' around the
+ * timed region, '<' and '>' around each iteration */
+#define ROI_BEGIN()            DEBUGCON_PUTC('[')
+#define ROI_END()              DEBUGCON_PUTC(']')
+#define ROI_ITERATION_BEGIN(i) do { (void)(i); DEBUGCON_PUTC('<'); } while (0)
+#define ROI_ITERATION_END(i)   do { (void)(i); DEBUGCON_PUTC('>'); } while (0)
+
+#elif (ROI_MARKERS == ROI_NONE)
+#define ROI_BEGIN()
+#define ROI_END()
+#define ROI_ITERATION_BEGIN(i)
+#define ROI_ITERATION_END(i)
+#else
+#error "Unknown ROI_MARKERS"
+#endif
+
+#if !ROI_ITERATIONS
+#undef ROI_ITERATION_BEGIN
+#undef ROI_ITERATION_END
+#define ROI_ITERATION_BEGIN(i)
+#define ROI_ITERATION_END(i)
+#endif
+
+#endif /* CORE_ROI_H */